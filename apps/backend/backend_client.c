@@ -198,16 +198,47 @@ netconf_db_find(cxobj *xn,
     return db;
 }
 
+/*! Send a positive rpc-reply with a data tree to a client
+ * The reply is streamed to the client socket instead of built in a cbuf,
+ * since data trees may be large.
+ * @param[in]  ce    Client session entry
+ * @param[in]  msg   Request message
+ * @param[in]  xdata Data tree, top element is <data>
+ * @see send_msg_reply_xml
+ */
+static int
+from_client_reply_data(struct client_entry *ce,
+		       struct clicon_msg   *msg,
+		       cxobj               *xdata)
+{
+    if (send_msg_reply_xml(ce->ce_s, msg, "<rpc-reply>", xdata, "</rpc-reply>") < 0){
+	switch (errno){
+	case EPIPE:
+	case ECONNRESET: /* client closed socket, see from_client_msg */
+	    clicon_log(LOG_WARNING, "client rpc reset");
+	    break;
+	default:
+	    return -1;
+	}
+    }
+    return 0;
+}
+
 /*! Internal message: get-config
  * 
  * @param[in]  h     Clicon handle
  * @param[in]  xe    Netconf request xml tree   
- * @param[out] cbret Return xml value cligen buffer
+ * @param[in]  ce    Client session entry
+ * @param[in]  msg   Request message
+ * @param[out] cbret Return xml value cligen buffer. Empty if reply is sent
+ * A positive reply is streamed directly to the client, see from_client_reply_data
  */
 static int
-from_client_get_config(clicon_handle h,
-		       cxobj        *xe,
-		       cbuf         *cbret)
+from_client_get_config(clicon_handle        h,
+		       cxobj               *xe,
+		       struct client_entry *ce,
+		       struct clicon_msg   *msg,
+		       cbuf                *cbret)
 {
     int    retval = -1;
     char  *db;
@@ -241,16 +272,14 @@ from_client_get_config(clicon_handle h,
 		"</rpc-error></rpc-reply>");
 	goto ok;
     }
-    cprintf(cbret, "<rpc-reply>");
     if (xret==NULL)
-	cprintf(cbret, "<data/>");
+	cprintf(cbret, "<rpc-reply><data/></rpc-reply>");
     else{
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0) < 0)
+	if (from_client_reply_data(ce, msg, xret) < 0)
 	    goto done;
     }
-    cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
@@ -263,13 +292,17 @@ from_client_get_config(clicon_handle h,
  * 
  * @param[in]  h     Clicon handle
  * @param[in]  xe    Netconf request xml tree   
- * @param[out] cbret Return xml value cligen buffer
+ * @param[in]  ce    Client session entry
+ * @param[in]  msg   Request message
+ * @param[out] cbret Return xml value cligen buffer. Empty if reply is sent
  * @see from_client_get_config
  */
 static int
-from_client_get(clicon_handle h,
-		cxobj        *xe,
-		cbuf         *cbret)
+from_client_get(clicon_handle        h,
+		cxobj               *xe,
+		struct client_entry *ce,
+		struct clicon_msg   *msg,
+		cbuf                *cbret)
 {
     int    retval = -1;
     cxobj *xfilter;
@@ -293,16 +326,14 @@ from_client_get(clicon_handle h,
     assert(xret);
     if (backend_statedata_call(h, selector, xret) < 0)
 	goto done;
-    cprintf(cbret, "<rpc-reply>");
     if (xret==NULL)
-	cprintf(cbret, "<data/>");
+	cprintf(cbret, "<rpc-reply><data/></rpc-reply>");
     else{
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0) < 0)
+	if (from_client_reply_data(ce, msg, xret) < 0)
 	    goto done;
     }
-    cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
@@ -923,7 +954,7 @@ from_client_msg(clicon_handle        h,
     while ((xe = xml_child_each(x, xe, CX_ELMNT)) != NULL) {
 	name = xml_name(xe);
 	if (strcmp(name, "get-config") == 0){
-	    if (from_client_get_config(h, xe, cbret) <0)
+	    if (from_client_get_config(h, xe, ce, msg, cbret) <0)
 		goto done;
 	}
 	else if (strcmp(name, "edit-config") == 0){
@@ -947,7 +978,7 @@ from_client_msg(clicon_handle        h,
 		goto done;
 	}
 	else if (strcmp(name, "get") == 0){
-	    if (from_client_get(h, xe, cbret) < 0)
+	    if (from_client_get(h, xe, ce, msg, cbret) < 0)
 		goto done;
 	}
 	else if (strcmp(name, "close-session") == 0){
@@ -1002,9 +1033,10 @@ from_client_msg(clicon_handle        h,
 	}
     }
  reply:
-    assert(cbuf_len(cbret));
+    if (cbuf_len(cbret) == 0) /* reply already sent, eg from_client_reply_data */
+	goto ok;
     clicon_debug(1, "%s %s", __FUNCTION__, cbuf_get(cbret));
-    if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
+    if (send_msg_reply(ce->ce_s, msg, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
 	switch (errno){
 	case EPIPE:
 	    /* man (2) write: 
@@ -1021,7 +1053,7 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	}
     }
-    // ok:
+ ok:
     retval = 0;
   done:
     if (xt)
@@ -1057,9 +1089,12 @@ from_client(int   s,
 	goto done;
     if (eof)
 	backend_client_rm(h, ce); 
-    else
+    else{
+	/* Reply (and notify) in the header version the client uses */
+	ce->ce_version = ntohs(msg->op_version);
 	if (from_client_msg(h, ce, msg) < 0)
 	    goto done;
+    }
     retval = 0;
   done:
     if (msg)
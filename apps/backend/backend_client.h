@@ -51,6 +51,7 @@ struct client_entry{
     int                    ce_stat_out;/* Nr of sent msgs to client */
     int                    ce_pid;   /* Process id */
     int                    ce_uid;   /* User id of calling process */
+    uint16_t               ce_version; /* Message header version used by client */
     clicon_handle          ce_handle; /* clicon config handle (all clients have same?) */
     struct client_subscription   *ce_subscription; /* notification subscriptions */
 };
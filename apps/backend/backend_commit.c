@@ -70,6 +70,26 @@
 #include "backend_commit.h"
 #include "backend_client.h"
 
+/*! Check if a removed or changed xml subtree may be referenced by a leafref
+ * @param[in]  x   XML node (source tree)
+ * @retval     1   Some node in the subtree may be a leafref target
+ * @retval     0   No node in the subtree is a leafref target
+ */
+static int
+generic_validate_leafref_target(cxobj *x)
+{
+    cxobj     *xc;
+    yang_stmt *ys;
+
+    if ((ys = xml_spec(x)) == NULL || yang_leafref_target(ys))
+	return 1;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (generic_validate_leafref_target(xc))
+	    return 1;
+    return 0;
+}
+
 /*! Key values are checked for validity independent of user-defined callbacks
  *
  * Key values are checked as follows:
@@ -79,6 +99,9 @@
  *    string regexp checked.
  * See also db_lv_set() where defaults are also filled in. The case here for defaults
  * are if code comes via XML/NETCONF.
+ * Only added and changed entries are validated (running is assumed to be valid),
+ * except leafrefs that are all validated if a node they may refer to is removed
+ * or changed.
  * @param   yspec   Yang spec
  * @param   td      Transaction data
  */
@@ -91,18 +114,27 @@ generic_validate(yang_spec          *yspec,
     cxobj          *x2;
     yang_stmt      *ys;
     int             i;
-
-    /* All entries */
-    if (xml_apply(td->td_target, CX_ELMNT, 
-		  (xml_applyfn_t*)xml_yang_validate_all, NULL) < 0)
-	goto done;
-
+    int             all = 0;
+
+    /* Removed or changed leafref targets: check all leafrefs */
+    for (i=0; i<td->td_dlen && !all; i++)
+	all = generic_validate_leafref_target(td->td_dvec[i]);
+    for (i=0; i<td->td_clen && !all; i++)
+	all = generic_validate_leafref_target(td->td_scvec[i]);
+    if (all){
+	/* All entries */
+	if (xml_apply(td->td_target, CX_ELMNT, 
+		      (xml_applyfn_t*)xml_yang_validate_all, NULL) < 0)
+	    goto done;
+    }
     /* changed entries */
     for (i=0; i<td->td_clen; i++){
 	x1 = td->td_scvec[i]; /* source changed */
 	x2 = td->td_tcvec[i]; /* target changed */
 	if (xml_yang_validate_add(x2, NULL) < 0)
 	    goto done;
+	if (!all && xml_yang_validate_all(x2, NULL) < 0)
+	    goto done;
     }
     /* deleted entries */
     for (i=0; i<td->td_dlen; i++){
@@ -120,6 +152,9 @@ generic_validate(yang_spec          *yspec,
 	if (xml_apply0(x2, CX_ELMNT, 
 		      (xml_applyfn_t*)xml_yang_validate_add, NULL) < 0)
 	    goto done;
+	if (!all && xml_apply0(x2, CX_ELMNT, 
+			       (xml_applyfn_t*)xml_yang_validate_all, NULL) < 0)
+	    goto done;
     }
     retval = 0;
  done:
@@ -222,6 +257,7 @@ candidate_commit(clicon_handle h,
 {
     int                retval = -1;
     transaction_data_t *td = NULL;
+    uint32_t           gen;
 
      /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
@@ -235,15 +271,18 @@ candidate_commit(clicon_handle h,
      if (plugin_transaction_commit(h, td) < 0)
 	 goto done;
 
-     /* 8. Success: Copy candidate to running */
-     if (xmldb_copy(h, candidate, "running") < 0)
+     /* 8. Success: Promote candidate to running */
+     if (xmldb_commit(h, candidate, "running") < 0)
 	 goto done;
 
     /* 9. Call plugin transaction end callbacks */
+    gen = xmldb_generation(h, "running");
     plugin_transaction_end(h, td);
 
-    /* 8. Copy running back to candidate in case end functions updated running */
-    if (xmldb_copy(h, "running", candidate) < 0){
+    /* 10. Candidate is equal to running after commit. Copy running back to 
+     * candidate only if end functions updated running */
+    if (xmldb_generation(h, "running") != gen &&
+	xmldb_copy(h, "running", candidate) < 0){
 	/* ignore errors or signal major setback ? */
 	clicon_log(LOG_NOTICE, "Error in rollback, trying to continue");
 	goto done;
@@ -522,6 +522,9 @@ main(int argc, char **argv)
 	goto done;
     if (xmldb_setopt(h, "yangspec", clicon_dbspec_yang(h)) < 0)
 	goto done;
+    if (clicon_xmldb_cache(h) &&
+	xmldb_setopt(h, "xml_cache", (void*)1) < 0)
+	goto done;
 
     /* First check for startup config 
        XXX the options below have become out-of-hand. 
@@ -146,7 +146,7 @@ backend_notify(clicon_handle h,
 	for (su = ce->ce_subscription; su; su = su->su_next)
 	    if (strcmp(su->su_stream, stream) == 0){
 		if (strlen(su->su_filter)==0 || fnmatch(su->su_filter, event, 0) == 0){
-		    if (send_msg_notify(ce->ce_s, level, event) < 0){
+		    if (send_msg_notify(ce->ce_s, ce->ce_version, level, event) < 0){
 			if (errno == ECONNRESET || errno == EPIPE){
 			    clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
 #if 0
@@ -224,7 +224,7 @@ backend_notify_xml(clicon_handle h,
 			if (clicon_xml2cbuf(cb, x, 0, 0) < 0)
 			    goto done;
 		    }
-		    if (send_msg_notify(ce->ce_s, level, cbuf_get(cb)) < 0){
+		    if (send_msg_notify(ce->ce_s, ce->ce_version, level, cbuf_get(cb)) < 0){
 			if (errno == ECONNRESET || errno == EPIPE){
 			    clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
 #if 0
@@ -282,6 +282,7 @@ backend_client_add(clicon_handle    h,
     }
     memset(ce, 0, sizeof(*ce));
     ce->ce_nr = bh->bh_ce_nr++;
+    ce->ce_version = CLICON_MSG_VERSION;
     memcpy(&ce->ce_addr, addr, sizeof(*addr));
     ce->ce_next = bh->bh_ce_list;
     bh->bh_ce_list = ce;
@@ -666,8 +666,10 @@ compare_dbs(clicon_handle h,
 	clicon_rpc_generate_error("Get configuration", xerr);
 	goto done;
     }
-    if (compare_xmls(xc1, xc2, astext) < 0) /* astext? */
-	goto done;
+    /* Identical trees have no differences to show */
+    if (xml_hash(xc1) != xml_hash(xc2))
+	if (compare_xmls(xc1, xc2, astext) < 0) /* astext? */
+	    goto done;
     retval = 0;
   done:
     if (xc1)
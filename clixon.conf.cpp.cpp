@@ -116,6 +116,10 @@ CLICON_XMLDB_DIR      localstatedir/APPNAME
 # XMLDB datastore plugin filename (see datastore/ and clixon_xml_db.[ch])
 CLICON_XMLDB_PLUGIN libdir/xmldb/text.so
 
+# Keep datastores parsed in memory in the xmldb plugin (text plugin only).
+# Reads are served from memory, writes are written through to file.
+# CLICON_XMLDB_CACHE 0
+
 # Dont include keys in cvec in cli vars callbacks, ie a & k in 'a <b> k <c>' ignored
 # CLICON_CLI_VARONLY      1
 
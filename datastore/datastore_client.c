@@ -71,7 +71,7 @@ sudo ./datastore_client -d candidate -b /usr/local/var/routing -p /home/olof/src
 #include <clixon/clixon.h>
 
 /* Command line options to be passed to getopt(3) */
-#define DATASTORE_OPTS "hDd:p:b:y:m:"
+#define DATASTORE_OPTS "hDd:p:b:y:m:c"
 
 /*! usage
  */
@@ -87,8 +87,10 @@ usage(char *argv0)
 		"\t-p <plugin>\tDatastore plugin. Mandatory\n"
 		"\t-y <dir>\tYang directory (where modules are stored). Mandatory\n"
 		"\t-m <module>\tYang module. Mandatory\n"
+		"\t-c\t\tKeep databases parsed in memory (xml_cache)\n"
 		"and command is either:\n"
 		"\tget <xpath>\n"
+		"\treget <xpath> <file> <xml>\tget, write xml to database file, get again\n"
 		"\tput (merge|replace|create|delete|remove) <xml>\n"
 		"\tcopy <todb>\n"
 		"\tlock <pid>\n"
@@ -121,6 +123,8 @@ main(int argc, char **argv)
     int                 pid;
     enum operation_type op;
     cxobj              *xt = NULL;
+    int                 cache = 0;
+    FILE               *f;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__PROGRAM__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -164,6 +168,9 @@ main(int argc, char **argv)
 	        usage(argv0);
 	    yangmodule = optarg;
 	    break;
+	case 'c': /* xml cache */
+	    cache = 1;
+	    break;
 	}
     /* 
      * Logs, error and debug to stderr, set debug level
@@ -210,6 +217,9 @@ main(int argc, char **argv)
     /* Set yang spec option */
     if (xmldb_setopt(h, "yangspec", yspec) < 0)
 	goto done;
+    /* Set xml cache option */
+    if (cache && xmldb_setopt(h, "xml_cache", (void*)1) < 0)
+	goto done;
     if (strcmp(cmd, "get")==0){
 	if (argc != 1 && argc != 2)
 	    usage(argv0);
@@ -219,6 +229,27 @@ main(int argc, char **argv)
 	
 	fprintf(stdout, "\n");
     }
+    else if (strcmp(cmd, "reget")==0){
+	if (argc != 4)
+	    usage(argv0);
+	if (xmldb_get(h, db, argv[1], 0, &xt) < 0)
+	    goto done;
+	clicon_xml2file(stdout, xt, 0, 0);	
+	fprintf(stdout, "\n");
+	xml_free(xt);
+	xt = NULL;
+	/* Write file in place, ie same inode and maybe same size and second */
+	if ((f = fopen(argv[2], "w")) == NULL){
+	    clicon_err(OE_UNIX, errno, "fopen(%s)", argv[2]);
+	    goto done;
+	}
+	fprintf(f, "%s", argv[3]);
+	fclose(f);
+	if (xmldb_get(h, db, argv[1], 0, &xt) < 0)
+	    goto done;
+	clicon_xml2file(stdout, xt, 0, 0);	
+	fprintf(stdout, "\n");
+    }
     else if (strcmp(cmd, "put")==0){
 	if (argc != 3){
 	    clicon_err(OE_DB, 0, "Unexpected nr of args: %d", argc);
@@ -452,6 +452,179 @@ get(char      *dbname,
     return retval;
 }
 
+/*! Find the value of a [<name>=<value>] predicate in a list of predicates
+ * @param[in]  pvec  Predicates without brackets, eg "name=eth0"
+ * @param[in]  npvec Length of pvec
+ * @param[in]  name  Predicate name
+ * @retval     value Value with quotes removed. Points into pvec
+ * @retval     NULL  Not found
+ */
+static char *
+predicate_value(char **pvec,
+		int    npvec,
+		char  *name)
+{
+    int   i;
+    char *p;
+    char *v;
+    char *ve;
+
+    for (i=0; i<npvec; i++){
+	p = pvec[i];
+	while (*p == ' ')
+	    p++;
+	if (strncmp(p, name, strlen(name)))
+	    continue;
+	v = p + strlen(name);
+	while (*v == ' ')
+	    v++;
+	if (*v++ != '=')
+	    continue;
+	while (*v == ' ')
+	    v++;
+	ve = v + strlen(v);
+	while (ve > v && ve[-1] == ' ')
+	    *--ve = '\0';
+	if (ve-v >= 2 && (*v == '"' || *v == '\'') && ve[-1] == *v){
+	    ve[-1] = '\0';
+	    v++;
+	}
+	return v;
+    }
+    return NULL;
+}
+
+/*! Translate the leading part of an xpath to a prefix of database keys
+ * Only absolute location paths of element names are translated, with list
+ * keys given as predicates, eg:
+ *   /interfaces/interface[name=eth0]/ipv4 -> /interfaces/interface=eth0/ipv4
+ * Translation stops at the first step that cannot be translated, eg a
+ * wildcard, a descendant step, or a list without all keys, so that the keys
+ * of all nodes that may match the xpath have the prefix.
+ * Since a prefix of keys is a prefix of strings, the character following
+ * the prefix in a key must also be checked: it must be end of string or one
+ * of the characters in sep. Eg /a matches /a/b, /a=1 or /a but not /ab.
+ * @param[in]  yspec  Yang spec
+ * @param[in]  xpath  Xpath, or NULL
+ * @param[out] cb     Prefix of keys. Empty if all keys may match.
+ * @param[out] sep    Characters that may follow prefix in a key
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see db_prefix
+ */
+static int
+kv_xpath2prefix(yang_spec *yspec,
+		char      *xpath,
+		cbuf      *cb,
+		char     **sep)
+{
+    int        retval = -1;
+    char      *s0 = NULL;
+    char      *s;
+    char      *step;
+    char      *name;
+    char      *pred;
+    char     **pvec = NULL;
+    int        npvec;
+    int        esc;
+    int        nkeys;
+    char      *v;
+    char      *enc;
+    yang_stmt *y = NULL;
+    cvec      *cvk;
+    cg_var    *cvi;
+    cbuf      *ckeys = NULL;
+
+    *sep = "";
+    if (xpath == NULL || xpath[0] != '/' || xpath[1] == '/' ||
+	strstr(xpath, " | ") != NULL)
+	goto ok;
+    if ((s0 = strdup(xpath+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if ((ckeys = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    s = s0;
+    while (*s != '\0'){
+	/* Chop off next step, eg "a[b=/c]" in "a[b=/c]/d" */
+	step = s;
+	for (esc=0; *s != '\0' && (esc || *s != '/'); s++)
+	    if (*s == '[')
+		esc++;
+	    else if (*s == ']')
+		esc--;
+	if (*s == '/')
+	    *s++ = '\0';
+	if ((pred = index(step, '[')) != NULL)
+	    *pred++ = '\0';
+	/* Strip prefix */
+	if ((name = index(step, ':')) != NULL)
+	    name++;
+	else
+	    name = step;
+	if (strlen(name) == 0 || 
+	    strspn(name, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"
+		   "0123456789_-.") != strlen(name) || 
+	    strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+	    break;
+	if (y == NULL)
+	    y = yang_find_topnode(yspec, name, 0);
+	else
+	    y = yang_find_datanode((yang_node*)y, name);
+	if (y == NULL)
+	    break;
+	cprintf(cb, "/%s", name);
+	*sep = "/=";
+	if (y->ys_keyword == Y_LEAF_LIST)
+	    break;
+	if (y->ys_keyword == Y_LIST){
+	    if (pred == NULL || yang_find((yang_node*)y, Y_KEY, NULL) == NULL)
+		break;
+	    if ((cvk = yang_key_cvec(y)) == NULL)
+		goto done;
+	    /* "name=eth0][type=eth]" -> "name=eth0", "type=eth" */
+	    if (strlen(pred) && pred[strlen(pred)-1] == ']')
+		pred[strlen(pred)-1] = '\0';
+	    if (pvec)
+		free(pvec);
+	    if ((pvec = clicon_strsep(pred, "][", &npvec)) == NULL)
+		goto done;
+	    nkeys = 0;
+	    cbuf_reset(ckeys);
+	    cvi = NULL;
+	    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+		if ((v = predicate_value(pvec, npvec, cv_string_get(cvi))) == NULL)
+		    break;
+		if (percent_encode(v, &enc) < 0)
+		    goto done;
+		cprintf(ckeys, "%s%s", nkeys++?",":"=", enc);
+		free(enc);
+	    }
+	    if (cvi != NULL) /* Not all keys given */
+		break;
+	    cprintf(cb, "%s", cbuf_get(ckeys));
+	    *sep = "/";
+	    if (npvec != nkeys) /* Other predicates than keys */
+		break;
+	}
+	else if (pred != NULL)
+	    break;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (ckeys)
+	cbuf_free(ckeys);
+    if (pvec)
+	free(pvec);
+    if (s0)
+	free(s0);
+    return retval;
+}
+
 /*! Connect to a datastore plugin
  * @retval  handle  Use this handle for other API calls
  * @retval  NULL    Error
@@ -580,6 +753,10 @@ kv_get(xmldb_handle  xh,
     int             npairs;
     struct db_pair *pairs;
     cxobj          *xt = NULL;
+    cbuf           *cb = NULL;
+    char           *sep;
+    size_t          plen;
+    char            c;
 
     clicon_debug(2, "%s", __FUNCTION__);
     if (kv_db2file(kh, db, &dbfile) < 0)
@@ -592,13 +769,25 @@ kv_get(xmldb_handle  xh,
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
 	goto done;
     }
-    /* Read in complete database (this can be optimized) */
-    if ((npairs = db_regexp(dbfile, "", __FUNCTION__, &pairs, 0)) < 0)
+    /* Read only the keys of nodes that may match xpath, eg the keys of a 
+     * single list entry. The tree is then filtered with xpath as before. */
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (kv_xpath2prefix(yspec, xpath, cb, &sep) < 0)
+	goto done;
+    if ((npairs = db_prefix(dbfile, cbuf_get(cb), __FUNCTION__, &pairs, 0)) < 0)
 	goto done;
-    if ((xt = xml_new_spec("config", NULL, yspec)) == NULL)
+    plen = strlen(cbuf_get(cb));
+    if ((xt = xml_new_arena("config")) == NULL)
 	goto done;
+    xml_spec_set(xt, yspec);
     /* Translate to complete xml tree */
     for (i = 0; i < npairs; i++) {
+	c = pairs[i].dp_key[plen];
+	if (c != '\0' && index(sep, c) == NULL) /* Eg /ab for prefix /a */
+	    continue;
 	if (get(dbfile, 
 		yspec, 
 		pairs[i].dp_key, /* xml key */
@@ -606,6 +795,7 @@ kv_get(xmldb_handle  xh,
 		xt) < 0)
 	    goto done;
     }
+    xml_arena_close(xt);
     if (xpath_vec(xt, xpath?xpath:"/", &xvec, &xlen) < 0)
 	goto done;
     /* If vectors are specified then filter out everything else,
@@ -619,15 +809,10 @@ kv_get(xmldb_handle  xh,
     if (!xml_flag(xt, XML_FLAG_MARK))
 	if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
 	    goto done;
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
-	goto done;
-    /* Add default values (if not set) */
-    if (xml_apply(xt, CX_ELMNT, xml_default, NULL) < 0)
-	goto done;
-    /* Order XML children according to YANG */
-    if (xml_apply(xt, CX_ELMNT, xml_order, NULL) < 0)
-	goto done;
-    if (xml_apply(xt, CX_ELMNT, xml_sanity, NULL) < 0)
+    /* In one pass: add default values in the selected (marked) subtrees, 
+     * order XML children according to YANG, check names and reset marks */
+    if (xml_finalize(xt, XML_FINALIZE_DEFAULT | XML_FINALIZE_ORDER |
+		     XML_FINALIZE_SANITY | XML_FINALIZE_MARKED) < 0)
 	goto done;
     if (debug>1)
     	clicon_xml2file(stderr, xt, 0, 1);
@@ -638,13 +823,15 @@ kv_get(xmldb_handle  xh,
 	free(dbfile);
     if (xvec)
 	free(xvec);
+    if (cb)
+	cbuf_free(cb);
     unchunk_group(__FUNCTION__);  
     return retval;
 
 }
 
 /*! Add data to database internal recursive function
- * @param[in]  dbfile Name of database to search in (filename incl dir path)
+ * @param[in]  dh     Open database with transaction, see dbh_open
  * @param[in]  xt     xml-node.
  * @param[in]  ys     Yang statement corresponding to xml-node
  * @param[in]  op     OP_MERGE, OP_REPLACE, OP_REMOVE, etc 
@@ -654,7 +841,7 @@ kv_get(xmldb_handle  xh,
  * @note XXX op only supports merge
  */
 static int
-put(char               *dbfile, 
+put(db_handle          *dh, 
     cxobj              *xt,
     yang_stmt          *ys, 
     enum operation_type op, 
@@ -702,7 +889,7 @@ put(char               *dbfile,
     /* Write to database, key and a vector of variables */
     switch (op){
     case OP_CREATE:
-	if ((exists = db_exists(dbfile, xk)) < 0)
+	if ((exists = dbh_exists(dh, xk)) < 0)
 	    goto done;
 	if (exists == 1){
 	    clicon_err(OE_DB, 0, "OP_CREATE: %s already exists in database", xk);
@@ -710,11 +897,11 @@ put(char               *dbfile,
 	}
     case OP_MERGE:
     case OP_REPLACE:
-	if (db_set(dbfile, xk, body?body:NULL, body?strlen(body)+1:0) < 0)
+	if (dbh_set(dh, xk, body?body:NULL, body?strlen(body)+1:0) < 0)
 	    goto done;
 	break;
     case OP_DELETE:
-	if ((exists = db_exists(dbfile, xk)) < 0)
+	if ((exists = dbh_exists(dh, xk)) < 0)
 	    goto done;
 	if (exists == 0){
 	    clicon_err(OE_DB, 0, "OP_DELETE: %s does not exists in database", xk);
@@ -726,30 +913,26 @@ put(char               *dbfile,
 	case Y_CONTAINER:{
 	    struct db_pair *pairs;
 	    int             npairs;
-	    cbuf           *cbrx;
 	    int             i;
+	    char            c;
 
-	    if ((cbrx = cbuf_new()) == NULL){
-		clicon_err(OE_UNIX, errno, "cbuf_new");
+	    if ((npairs = dbh_prefix(dh, xk, __FUNCTION__, &pairs, 1)) < 0)
 		goto done;
-	    }
-	    cprintf(cbrx, "^%s.*$", xk);
-	    if ((npairs = db_regexp(dbfile, cbuf_get(cbrx), __FUNCTION__, 
-				    &pairs, 0)) < 0)
-		goto done;
-	    /* Translate to complete xml tree */
-	    for (i = 0; i < npairs; i++) 
-		if (db_del(dbfile, pairs[i].dp_key) < 0)
+	    /* Delete the subtree, but not eg /a=12 when deleting /a=1 */
+	    for (i = 0; i < npairs; i++){
+		c = pairs[i].dp_key[strlen(xk)];
+		if (c != '\0' && c != '/')
+		    continue;
+		if (dbh_del(dh, pairs[i].dp_key) < 0)
 		    goto done;
-	    if (cbrx)
-		cbuf_free(cbrx);
+	    }
 	    /* Skip recursion, we have deleted whole subtree */
 	    retval = 0;
 	    goto done;
 	    break;
 	}
 	default:
-	    if (db_del(dbfile, xk) < 0)
+	    if (dbh_del(dh, xk) < 0)
 		goto done;
 	    break;
 	}
@@ -764,7 +947,7 @@ put(char               *dbfile,
 	    clicon_err(OE_UNIX, 0, "No yang node found: %s", xml_name(x));
 	    goto done;
 	}
-	if (put(dbfile, x, y, op, xk) < 0)
+	if (put(dh, x, y, op, xk) < 0)
 	    goto done;
     }
     retval = 0;
@@ -778,6 +961,8 @@ put(char               *dbfile,
 }
 
 /*! Modify database provided an xml tree and an operation
+ * The database is opened once and all keys are written in one transaction,
+ * so that either all or none of the modifications are made.
  * This is a clixon datastore plugin of the the xmldb api
  * @see xmldb_put
  */
@@ -793,6 +978,10 @@ kv_put(xmldb_handle        xh,
     yang_stmt *ys;
     yang_spec *yspec;
     char      *dbfilename = NULL;
+    db_handle *dh = NULL;
+    struct db_pair *pairs;
+    int        npairs;
+    int        i;
 
     if ((yspec =  kh->kh_yangspec) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
@@ -801,10 +990,17 @@ kv_put(xmldb_handle        xh,
     if (kv_db2file(kh, db, &dbfilename) < 0)
 	goto done;
     if (op == OP_REPLACE){
-	if (db_delete(dbfilename) < 0) 
+	if (db_init(dbfilename) < 0) /* Create if not exists */
 	    goto done;
-	if (db_init(dbfilename) < 0) 
+    }
+    if ((dh = dbh_open(dbfilename)) == NULL)
+	goto done;
+    if (op == OP_REPLACE){ /* Delete all keys in the transaction */
+	if ((npairs = dbh_prefix(dh, "", __FUNCTION__, &pairs, 1)) < 0)
 	    goto done;
+	for (i = 0; i < npairs; i++)
+	    if (dbh_del(dh, pairs[i].dp_key) < 0)
+		goto done;
     }
     //	clicon_log(LOG_WARNING, "%s", __FUNCTION__);
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
@@ -812,7 +1008,7 @@ kv_put(xmldb_handle        xh,
 	    clicon_err(OE_UNIX, errno, "No yang node found: %s", xml_name(x));
 	    goto done;
 	}
-	if (put(dbfilename, /* database name */
+	if (put(dh,         /* open database */
 		x,          /* xml root node */
 		ys,         /* yang statement of xml node */
 		op,         /* operation, eg merge/delete */
@@ -822,8 +1018,11 @@ kv_put(xmldb_handle        xh,
     }
     retval = 0;
  done:
+    if (dh && dbh_close(dh, retval == 0) < 0)
+	retval = -1;
     if (dbfilename)
 	free(dbfilename);
+    unchunk_group(__FUNCTION__);
     return retval;
 }
 
@@ -860,6 +1059,54 @@ kv_copy(xmldb_handle xh,
     return retval;
 }
 
+/*! Promote database from to database to, eg candidate to running
+ * The database file is copied to a temporary file which replaces the file of
+ * to, so that to is replaced atomically.
+ * @param[in]  xh    XMLDB handle
+ * @param[in]  from  Source database, eg "candidate". Not changed
+ * @param[in]  to    Destination database, eg "running"
+ * @retval -1  Error
+ * @retval  0  OK
+ * @note qdbm updates files in place, so database files cannot share inode
+ */
+int 
+kv_commit(xmldb_handle xh, 
+	  char        *from,
+	  char        *to)
+{
+    int               retval = -1;
+    struct kv_handle *kh = handle(xh);
+    char             *fromfile = NULL;
+    char             *tofile = NULL;
+    cbuf             *cb = NULL;
+
+    if (kv_db2file(kh, from, &fromfile) < 0)
+	goto done;
+    if (kv_db2file(kh, to, &tofile) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s.tmp", tofile);
+    if (clicon_file_copy(fromfile, cbuf_get(cb)) < 0)
+	goto done;
+    if (rename(cbuf_get(cb), tofile) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s, %s)", cbuf_get(cb), tofile);
+	unlink(cbuf_get(cb));
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (fromfile)
+	free(fromfile);
+    if (tofile)
+	free(tofile);
+    return retval;
+}
+
 /*! Lock database
  * @param[in]  xh      XMLDB handle
  * @param[in]  db   Database
@@ -1067,7 +1314,7 @@ clixon_xmldb_plugin_init(int version)
 }
 
 static const struct xmldb_api api = {
-    1,
+    XMLDB_API_VERSION,
     XMLDB_API_MAGIC,
     clixon_xmldb_plugin_init,
     kv_plugin_exit,
@@ -1085,6 +1332,7 @@ static const struct xmldb_api api = {
     kv_exists,
     kv_delete,
     kv_create,
+    kv_commit,
 };
 
 
@@ -43,6 +43,7 @@ int kv_get(xmldb_handle h, char *db, char *xpath, int config, cxobj **xtop);
 int kv_put(xmldb_handle h, char *db, enum operation_type op, cxobj *xt);
 int kv_dump(FILE *f, char *dbfilename, char *rxkey);
 int kv_copy(xmldb_handle h, char *from, char *to);
+int kv_commit(xmldb_handle h, char *from, char *to);
 int kv_lock(xmldb_handle h, char *db, int pid);
 int kv_unlock(xmldb_handle h, char *db);
 int kv_unlock_all(xmldb_handle h, int pid);
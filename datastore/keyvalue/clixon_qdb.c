@@ -31,20 +31,23 @@
 
   ***** END LICENSE BLOCK *****
 
- * @note Some unclarities with locking. man dpopen defines the following flags
- *       with dpopen:
- *       `DP_ONOLCK', which means it opens a database file without 
+ * The database is a QDBM Villa B+ tree with keys in lexical order, so that
+ * all keys with a common prefix, eg all keys of a subtree, are read with a
+ * cursor, see db_prefix.
+ * @note Some unclarities with locking. man vlopen defines the following flags
+ *       with vlopen:
+ *       `VL_ONOLCK', which means it opens a database file without 
  *                    file locking,  
- *       `DP_OLCKNB', which means locking is performed without blocking.
+ *       `VL_OLCKNB', which means locking is performed without blocking.
  *
  *        While connecting as  a  writer, an  exclusive  lock is invoked to 
  *        the database file.  While connecting as a reader, a shared lock is
  *        invoked to the database file. The thread blocks until the lock is 
- *        achieved.  If `DP_ONOLCK' is used, the application is responsible  
+ *        achieved.  If `VL_ONOLCK' is used, the application is responsible  
  *        for  exclusion control.
  *        The code below uses for 
- *          write, delete:  DP_OLCKNB
- *          read:           DP_OLCKNB
+ *          write, delete:  VL_OLCKNB
+ *          read:           VL_OLCKNB
  *        This means that a write fails if one or many reads are occurring, and
  *        a read or write fails if a write is occurring, and
  *        QDBM allows a single write _or_ multiple readers, but
@@ -71,8 +74,12 @@
 
 #ifdef HAVE_DEPOT_H
 #include <depot.h> /* qdb api */
+#include <cabin.h>
+#include <villa.h>
 #else /* HAVE_QDBM_DEPOT_H */
 #include <qdbm/depot.h> /* qdb api */
+#include <qdbm/cabin.h>
+#include <qdbm/villa.h>
 #endif 
 
 #include <cligen/cligen.h>
@@ -83,26 +90,34 @@
 #include "clixon_chunk.h"
 #include "clixon_qdb.h" 
 
+/* Initial allocated length of pair vector, doubled when full */
+#define DB_PAIRS_START 16
+
+/* Open database with a transaction, see dbh_open */
+struct db_handle {
+    VILLA *dh_vl;
+};
+
 /*! Initialize database
  * @param[in]  file    database file
- * @param[in]  omode   see man dpopen
+ * @param[in]  omode   see man vlopen
  */
 static int 
 db_init_mode(char *file, 
 	     int   omode)
 {
-    DEPOT *dp;
+    VILLA *vl;
 
     /* Open database for writing */
-    if ((dp = dpopen(file, omode | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, errno, "dpopen(%s): %s", 
+    if ((vl = vlopen(file, omode | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "vlopen(%s): %s", 
 		   file, 
 		   dperrmsg(dpecode));
 	return -1;
     }
     clicon_debug(1, "db_init(%s)", file);
-    if (dpclose(dp) == 0){
-	clicon_err(OE_DB, errno, "db_set: dpclose: %s", 
+    if (vlclose(vl) == 0){
+	clicon_err(OE_DB, errno, "db_set: vlclose: %s", 
 		   dperrmsg(dpecode));
 	return -1;
     }
@@ -115,7 +130,7 @@ db_init_mode(char *file,
 int 
 db_init(char *file)
 {
-    return db_init_mode(file, DP_OWRITER | DP_OCREAT ); /* DP_OTRUNC? */
+    return db_init_mode(file, VL_OWRITER | VL_OCREAT ); /* VL_OTRUNC? */
 }
 
 /*! Remove database by removing file, if it exists *
@@ -150,28 +165,28 @@ db_set(char  *file,
        void  *data, 
        size_t datalen)
 {
-    DEPOT *dp;
+    VILLA *vl;
 
     /* Open database for writing */
-    if ((dp = dpopen(file, DP_OWRITER|DP_OLCKNB , 0)) == NULL){
-	clicon_err(OE_DB, errno, "db_set: dpopen(%s): %s", 
+    if ((vl = vlopen(file, VL_OWRITER|VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "db_set: vlopen(%s): %s", 
 		file,
 		dperrmsg(dpecode));
 	return -1;
     }
     clicon_debug(2, "%s: db_put(%s, len:%d)", 
 		file, key, (int)datalen);
-    if (dpput(dp, key, -1, data, datalen, DP_DOVER) == 0){
-	clicon_err(OE_DB, errno, "%s: db_set: dpput(%s, %d): %s", 
+    if (vlput(vl, key, -1, data, datalen, VL_DOVER) == 0){
+	clicon_err(OE_DB, errno, "%s: db_set: vlput(%s, %d): %s", 
 		file,
 		key,
 		datalen,
 		dperrmsg(dpecode));
-	dpclose(dp);
+	vlclose(vl);
 	return -1;
     }
-    if (dpclose(dp) == 0){
-	clicon_err(OE_DB, 0, "db_set: dpclose: %s", dperrmsg(dpecode));
+    if (vlclose(vl) == 0){
+	clicon_err(OE_DB, 0, "db_set: vlclose: %s", dperrmsg(dpecode));
 	return -1;
     }
     return 0;
@@ -192,36 +207,41 @@ db_get(char   *file,
        void   *data, 
        size_t *datalen)
 {
-    DEPOT *dp;
-    int len;
+    VILLA *vl;
+    char  *val;
+    int    len;
 
     /* Open database for readinf */
-    if ((dp = dpopen(file, DP_OREADER | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, errno, "%s: db_get(%s, %d): dpopen: %s", 
+    if ((vl = vlopen(file, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "%s: db_get(%s, %d): vlopen: %s", 
 		file,
 		key,
 		datalen,
 		dperrmsg(dpecode));
 	return -1;
     }
-    len = dpgetwb(dp, key, -1, 0, *datalen, data);
-    if (len < 0){
+    if ((val = vlget(vl, key, -1, &len)) == NULL){
 	if (dpecode == DP_ENOITEM){
 	    data = NULL;
 	    *datalen = 0;
 	}
 	else{
-	    clicon_err(OE_DB, errno, "db_get: dpgetwb: %s (%d)", 
+	    clicon_err(OE_DB, errno, "db_get: vlget: %s (%d)", 
 		    dperrmsg(dpecode), dpecode);
-	    dpclose(dp);
+	    vlclose(vl);
 	    return -1;
 	}
     }
-    else
+    else{
+	if (len > *datalen) /* Truncate to buffer */
+	    len = *datalen;
+	memcpy(data, val, len);
 	*datalen = len;	
+	free(val);
+    }
     clicon_debug(2, "db_get(%s, %s)=%s", file, key, (char*)data);
-    if (dpclose(dp) == 0){
-	clicon_err(OE_DB, errno, "db_get: dpclose: %s", dperrmsg(dpecode));
+    if (vlclose(vl) == 0){
+	clicon_err(OE_DB, errno, "db_get: vlclose: %s", dperrmsg(dpecode));
 	return -1;
     }
     return 0;
@@ -254,18 +274,18 @@ db_get_alloc(char   *file,
 	     void  **data, 
 	     size_t *datalen)
 {
-    DEPOT *dp;
+    VILLA *vl;
     int len;
 
     /* Open database for writing */
-    if ((dp = dpopen(file, DP_OREADER | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, errno, "%s: dpopen(%s): %s", 
+    if ((vl = vlopen(file, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "%s: vlopen(%s): %s", 
 		   __FUNCTION__,
 		   file,
 		   dperrmsg(dpecode));
 	return -1;
     }
-    if ((*data = dpget(dp, key, -1, 0, -1, &len)) == NULL){
+    if ((*data = vlget(vl, key, -1, &len)) == NULL){
 	if (dpecode == DP_ENOITEM){
 	    *datalen = 0;
 	    *data = NULL;
@@ -273,15 +293,15 @@ db_get_alloc(char   *file,
 	}
 	else{
 	    /* No entry vs error? */
-	    clicon_err(OE_DB, errno, "db_get_alloc: dpgetwb: %s (%d)", 
+	    clicon_err(OE_DB, errno, "db_get_alloc: vlget: %s (%d)", 
 		    dperrmsg(dpecode), dpecode);
-	    dpclose(dp);
+	    vlclose(vl);
 	    return -1;
 	}
     }
     *datalen = len;
-    if (dpclose(dp) == 0){
-	clicon_err(OE_DB, errno, "db_get_alloc: dpclose: %s", dperrmsg(dpecode));
+    if (vlclose(vl) == 0){
+	clicon_err(OE_DB, errno, "db_get_alloc: vlclose: %s", dperrmsg(dpecode));
 	return -1;
     }
     return 0;
@@ -298,20 +318,20 @@ int
 db_del(char *file, char *key)
 {
     int retval = 0;
-    DEPOT *dp;
+    VILLA *vl;
 
     /* Open database for writing */
-    if ((dp = dpopen(file, DP_OWRITER | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, errno, "db_del: dpopen(%s): %s", 
+    if ((vl = vlopen(file, VL_OWRITER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "db_del: vlopen(%s): %s", 
 		file,
 		dperrmsg(dpecode));
 	return -1;
     }
-    if (dpout(dp, key, -1)) {
+    if (vlout(vl, key, -1)) {
         retval = 1;
     }
-    if (dpclose(dp) == 0){
-	clicon_err(OE_DB, errno, "db_del: dpclose: %s", dperrmsg(dpecode));
+    if (vlclose(vl) == 0){
+	clicon_err(OE_DB, errno, "db_del: vlclose: %s", dperrmsg(dpecode));
 	return -1;
     }
     return retval;
@@ -328,29 +348,101 @@ int
 db_exists(char *file, 
 	  char *key)
 {
-    DEPOT *dp;
+    VILLA *vl;
     int len;
 
     /* Open database for reading */
-    if ((dp = dpopen(file, DP_OREADER | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, errno, "%s: dpopen: %s", 
+    if ((vl = vlopen(file, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "%s: vlopen: %s", 
 		   __FUNCTION__, dperrmsg(dpecode));
 	return -1;
     }
 
-    len = dpvsiz(dp, key, -1);
+    len = vlvsiz(vl, key, -1);
     if (len < 0 && dpecode != DP_ENOITEM)
-	clicon_err(OE_DB, errno, "^s: dpvsiz: %s (%d)", 
+	clicon_err(OE_DB, errno, "^s: vlvsiz: %s (%d)", 
 		   __FUNCTION__, dperrmsg(dpecode), dpecode);
 
-    if (dpclose(dp) == 0) {
-	clicon_err(OE_DB, errno, "%s: dpclose: %s", dperrmsg(dpecode),__FUNCTION__);
+    if (vlclose(vl) == 0) {
+	clicon_err(OE_DB, errno, "%s: vlclose: %s", dperrmsg(dpecode),__FUNCTION__);
 	return -1;
     }
 
     return (len < 0) ? 0 : 1;
 }
 
+/*! Add the key and value at the database cursor to a vector of pairs
+ * The vector is doubled when full.
+ * @param[in]     vl       Database with cursor at entry
+ * @param[in]     key      Key at cursor
+ * @param[in]     matched  Matched component of key
+ * @param[in]     matchlen Length of matched component
+ * @param[in]     label    For memory/chunk allocation
+ * @param[in,out] pairs    Vector of database keys and values
+ * @param[in,out] npairs   Length of pairs
+ * @param[in,out] maxpairs Allocated length of pairs
+ * @param[in]     noval    If set don't retreive values, just keys
+ */
+static int
+db_pair_add(VILLA           *vl,
+	    char            *key,
+	    char            *matched,
+	    int              matchlen,
+	    const char      *label, 
+	    struct db_pair **pairs,
+	    int             *npairs,
+	    int             *maxpairs,
+	    int              noval)
+{
+    int             retval = -1;
+    struct db_pair *newpairs;
+    struct db_pair *pair;
+    char           *val = NULL;
+    int             vlen = 0;
+
+    /* Retrieve value if required */
+    if ( ! noval) {
+	if((val = vlcurval(vl, &vlen)) == NULL) {
+	    clicon_log(LOG_WARNING, "%s: vlcurval: %s", __FUNCTION__, dperrmsg(dpecode));
+	    goto done;
+	}
+    }
+    /* Resize and populate resulting array */
+    if (*npairs == *maxpairs){
+	*maxpairs = *maxpairs ? 2*(*maxpairs) : DB_PAIRS_START;
+	newpairs = rechunk(*pairs, *maxpairs * sizeof(struct db_pair), label);
+	if (newpairs == NULL) {
+	    clicon_err(OE_DB, errno, "%s: rechunk", __FUNCTION__);
+	    goto done;
+	}
+	*pairs = newpairs;
+    }
+    pair = &(*pairs)[*npairs];
+    memset (pair, 0, sizeof(*pair));
+    pair->dp_key = chunk_sprintf(label, "%s", key);
+    pair->dp_matched = chunk_sprintf(label, "%.*s", matchlen, matched);
+    if (pair->dp_key == NULL || pair->dp_matched == NULL) {
+	clicon_err(OE_DB, errno, "%s: chunk_sprintf", __FUNCTION__);
+	goto done;
+    }
+    if ( ! noval) {
+	if (vlen){
+	    pair->dp_val = chunkdup (val, vlen, label);
+	    if (pair->dp_val == NULL) {
+		clicon_err(OE_DB, errno, "%s: chunkdup", __FUNCTION__);
+		goto done;
+	    }
+	}
+	pair->dp_vlen = vlen;
+    }
+    (*npairs)++;
+    retval = 0;
+ done:
+    if (val)
+	free(val);
+    return retval;
+}
+
 /*! Return all entries in database that match a regular expression.
  * @param[in]  file    database file
  * @param[in]  regexp  regular expression for database keys
@@ -367,6 +459,7 @@ db_exists(char *file,
  *    err;
  * 
  * @endcode
+ * @see db_prefix  Faster if keys have a common prefix
  */
 int
 db_regexp(char            *file,
@@ -376,16 +469,13 @@ db_regexp(char            *file,
 	  int              noval)
 {
     int npairs;
+    int maxpairs = 0;
     int status;
     int retval = -1;
-    int vlen = 0;
     char *key = NULL;
-    void *val = NULL;
     char errbuf[512];
-    struct db_pair *pair;
-    struct db_pair *newpairs;
     regex_t iterre;
-    DEPOT *iterdp = NULL;
+    VILLA *vl = NULL;
     regmatch_t pmatch[1];
     size_t nmatch = 1;
     
@@ -401,89 +491,319 @@ db_regexp(char            *file,
     }
     
     /* Open database for reading */
-    if ((iterdp = dpopen(file, DP_OREADER | DP_OLCKNB, 0)) == NULL){
-	clicon_err(OE_DB, 0, "%s: dpopen(%s): %s", 
+    if ((vl = vlopen(file, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, 0, "%s: vlopen(%s): %s", 
 		   __FUNCTION__, file, dperrmsg(dpecode));
 	goto quit;
     }
     
-    /* Initiate iterator */
-    if(dpiterinit(iterdp) == 0) {
-	clicon_err(OE_DB, errno, "%s: dpiterinit: %s", __FUNCTION__, dperrmsg(dpecode));
-	goto quit;
-    }
-    
     /* Iterate through DB */
-    while((key = dpiternext(iterdp, NULL)) != NULL) {
-	
-	if (regexp && regexec(&iterre, key, nmatch, pmatch, 0) != 0) {
-	    free(key);
-	    continue;
-	}
-	
-	/* Retrieve value if required */
-	if ( ! noval) {
-	    if((val = dpget(iterdp, key, -1, 0, -1, &vlen)) == NULL) {
-		clicon_log(LOG_WARNING, "%s: dpget: %s", __FUNCTION__, dperrmsg(dpecode));
+    if (vlcurfirst(vl))
+	while((key = vlcurkey(vl, NULL)) != NULL) {
+	    if (regexp == NULL)
+		status = db_pair_add(vl, key, key, strlen(key), label, 
+				     pairs, &npairs, &maxpairs, noval);
+	    else if (regexec(&iterre, key, nmatch, pmatch, 0) == 0)
+		status = db_pair_add(vl, key, key + pmatch[0].rm_so,
+				     pmatch[0].rm_eo - pmatch[0].rm_so, label, 
+				     pairs, &npairs, &maxpairs, noval);
+	    else
+		status = 0;
+	    if (status < 0)
 		goto quit;
-	    }
-	}
-
-	/* Resize and populate resulting array */
-	newpairs = rechunk(*pairs, (npairs+1) * sizeof(struct db_pair), label);
-	if (newpairs == NULL) {
-	    clicon_err(OE_DB, errno, "%s: rechunk", __FUNCTION__);
-	    goto quit;
-	}
-	pair = &newpairs[npairs];
-	memset (pair, 0, sizeof(*pair));
-	
-	pair->dp_key = chunk_sprintf(label, "%s", key);
-	if (regexp)
-	    pair->dp_matched = chunk_sprintf(label, "%.*s",
-					     pmatch[0].rm_eo - pmatch[0].rm_so,
-					     key + pmatch[0].rm_so);
-	else
-	    pair->dp_matched = chunk_sprintf(label, "%s", key);
-	if (pair->dp_key == NULL || pair->dp_matched == NULL) {
-	    clicon_err(OE_DB, errno, "%s: chunk_sprintf");
-	    goto quit;
-	}
-	if ( ! noval) {
-	    if (vlen){
-		pair->dp_val = chunkdup (val, vlen, label);
-		if (pair->dp_val == NULL) {
-		    clicon_err(OE_DB, errno, "%s: chunkdup", __FUNCTION__);
-		    goto quit;
-		}
-	    }
-	    pair->dp_vlen = vlen;
-	    free(val);
-	    val = NULL;
+	    free(key);
+	    key = NULL;
+	    if (vlcurnext(vl) == 0)
+		break;
 	}
-
-	(*pairs) = newpairs;
-	npairs++;
-	free(key);
-    }
-	
     retval = npairs;
     
 quit:
     if (key)
 	free(key);
-    if (val)
-	free(val);
     if (regexp)
 	regfree(&iterre);
-    if (iterdp)
-	dpclose(iterdp);
+    if (vl)
+	vlclose(vl);
     if (retval < 0)
 	unchunk_group(label);
 
     return retval;
 }
 
+/*! Read all entries whose key start with a prefix using a cursor
+ * @param[in]  vl      Open database
+ * @param[in]  prefix  Prefix of database keys. "" for all keys
+ * @param[in]  label   for memory/chunk allocation
+ * @param[out] pairs   Vector of database keys and values, in key order
+ * @param[in]  noval   If set don't retreive values, just keys
+ * @retval -1  on error   
+ * @retval  n  Number of pairs
+ * @see db_prefix
+ */
+static int
+db_cursor_prefix(VILLA           *vl,
+		 char            *prefix, 
+		 const char      *label, 
+		 struct db_pair **pairs,
+		 int              noval)
+{
+    int    retval = -1;
+    int    npairs = 0;
+    int    maxpairs = 0;
+    int    plen;
+    char  *key = NULL;
+    int    ok;
+    
+    *pairs = NULL;
+    plen = strlen(prefix);
+    if (plen)
+	ok = vlcurjump(vl, prefix, plen, VL_JFORWARD);
+    else
+	ok = vlcurfirst(vl);
+    if (ok)
+	while((key = vlcurkey(vl, NULL)) != NULL) {
+	    if (strncmp(key, prefix, plen) != 0) /* Past prefix range */
+		break;
+	    if (db_pair_add(vl, key, key, plen, label, 
+			    pairs, &npairs, &maxpairs, noval) < 0)
+		goto quit;
+	    free(key);
+	    key = NULL;
+	    if (vlcurnext(vl) == 0)
+		break;
+	}
+    retval = npairs;
+quit:
+    if (key)
+	free(key);
+    if (retval < 0)
+	unchunk_group(label);
+    return retval;
+}
+
+/*! Return all entries in database whose key start with a prefix
+ * The keys are in lexical order, so the entries are read with a cursor from
+ * the first key not less than the prefix until the first key without the
+ * prefix. The cost is proportional to the number of matching entries, not to
+ * the size of the database.
+ * @param[in]  file    database file
+ * @param[in]  prefix  Prefix of database keys. "" for all keys
+ * @param[in]  label   for memory/chunk allocation
+ * @param[out] pairs   Vector of database keys and values, in key order
+ * @param[in]  noval   If set don't retreive values, just keys
+ * @retval -1  on error   
+ * @retval  n  Number of pairs
+ * @code
+ * struct db_pair *pairs;
+ * int             npairs;
+ * if ((npairs = db_prefix(dbname, "/interfaces/interface=eth0", 
+ *                         __FUNCTION__, &pairs, 0)) < 0)
+ *    err;
+ * @endcode
+ * @note The prefix is a string prefix, "/a=1" also matches "/a=12"
+ * @see db_regexp
+ * @see dbh_prefix  Same on an open database
+ */
+int
+db_prefix(char            *file,
+	  char            *prefix, 
+	  const char      *label, 
+	  struct db_pair **pairs,
+	  int              noval)
+{
+    int    retval = -1;
+    VILLA *vl = NULL;
+    
+    *pairs = NULL;
+    /* Open database for reading */
+    if ((vl = vlopen(file, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, 0, "%s: vlopen(%s): %s", 
+		   __FUNCTION__, file, dperrmsg(dpecode));
+	unchunk_group(label);
+	goto done;
+    }
+    retval = db_cursor_prefix(vl, prefix, label, pairs, noval);
+ done:
+    if (vl)
+	vlclose(vl);
+    return retval;
+}
+
+/*! Open database for writing and start a transaction
+ * All modifications made with the handle are applied together when the 
+ * handle is closed with commit, and none of them if closed without commit.
+ * This is much faster than db_set and db_del for many keys since the 
+ * database is opened, locked and synced only once.
+ * @param[in]  file    database file
+ * @retval     dh      Database handle, close with dbh_close
+ * @retval     NULL    Error
+ * @code
+ *  db_handle *dh;
+ *  if ((dh = dbh_open(dbname)) == NULL)
+ *     err;
+ *  if (dbh_set(dh, "/a", "x", 2) < 0){
+ *     dbh_close(dh, 0);
+ *     err;
+ *  }
+ *  if (dbh_close(dh, 1) < 0)
+ *     err;
+ * @endcode
+ */
+db_handle *
+dbh_open(char *file)
+{
+    db_handle *dh;
+
+    if ((dh = malloc(sizeof(*dh))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(dh, 0, sizeof(*dh));
+    if ((dh->dh_vl = vlopen(file, VL_OWRITER|VL_OLCKNB, VL_CMPLEX)) == NULL){
+	clicon_err(OE_DB, errno, "%s: vlopen(%s): %s", 
+		   __FUNCTION__, file, dperrmsg(dpecode));
+	free(dh);
+	return NULL;
+    }
+    if (vltranbegin(dh->dh_vl) == 0){
+	clicon_err(OE_DB, errno, "%s: vltranbegin(%s): %s", 
+		   __FUNCTION__, file, dperrmsg(dpecode));
+	vlclose(dh->dh_vl);
+	free(dh);
+	return NULL;
+    }
+    clicon_debug(2, "%s(%s)", __FUNCTION__, file);
+    return dh;
+}
+
+/*! Commit or abort transaction and close database
+ * @param[in]  dh      Database handle from dbh_open. Freed.
+ * @param[in]  commit  If set commit modifications, otherwise discard them
+ * @retval     0       OK
+ * @retval    -1       Error. Transaction is not committed
+ */
+int
+dbh_close(db_handle *dh,
+	  int        commit)
+{
+    int retval = -1;
+
+    if (commit){
+	if (vltrancommit(dh->dh_vl) == 0){
+	    clicon_err(OE_DB, errno, "%s: vltrancommit: %s", 
+		       __FUNCTION__, dperrmsg(dpecode));
+	    vltranabort(dh->dh_vl);
+	    vlclose(dh->dh_vl);
+	    goto done;
+	}
+    }
+    else if (vltranabort(dh->dh_vl) == 0){
+	clicon_err(OE_DB, errno, "%s: vltranabort: %s", 
+		   __FUNCTION__, dperrmsg(dpecode));
+	vlclose(dh->dh_vl);
+	goto done;
+    }
+    if (vlclose(dh->dh_vl) == 0){
+	clicon_err(OE_DB, errno, "%s: vlclose: %s", 
+		   __FUNCTION__, dperrmsg(dpecode));
+	goto done;
+    }
+    retval = 0;
+ done:
+    free(dh);
+    return retval;
+}
+
+/*! Write data to an open database
+ * @param[in]  dh      Database handle from dbh_open
+ * @param[in]  key     database key
+ * @param[in]  data    Buffer containing content
+ * @param[in]  datalen Length of buffer
+ * @retval  0 OK
+ * @retval -1 on error   
+ * @see db_set
+ */
+int 
+dbh_set(db_handle *dh,
+	char      *key, 
+	void      *data, 
+	size_t     datalen)
+{
+    clicon_debug(2, "%s(%s, len:%d)", __FUNCTION__, key, (int)datalen);
+    if (vlput(dh->dh_vl, key, -1, data, datalen, VL_DOVER) == 0){
+	clicon_err(OE_DB, errno, "%s: vlput(%s, %d): %s", 
+		   __FUNCTION__, key, datalen, dperrmsg(dpecode));
+	return -1;
+    }
+    return 0;
+}
+
+/*! Delete entry in an open database
+ * @param[in]  dh      Database handle from dbh_open
+ * @param[in]  key     database key
+ * @retval  -1  on failure, 
+ * @retval   0  if key did not exist 
+ * @retval   1  if successful.
+ * @see db_del
+ */
+int 
+dbh_del(db_handle *dh,
+	char      *key)
+{
+    if (vlout(dh->dh_vl, key, -1))
+	return 1;
+    if (dpecode != DP_ENOITEM){
+	clicon_err(OE_DB, errno, "%s: vlout(%s): %s", 
+		   __FUNCTION__, key, dperrmsg(dpecode));
+	return -1;
+    }
+    return 0;
+}
+
+/*! Check if entry in an open database exists
+ * @param[in]  dh      Database handle from dbh_open
+ * @param[in]  key     database key
+ * @retval  1  if key exists in database
+ * @retval  0  key does not exist in database
+ * @retval -1  error
+ * @see db_exists
+ */
+int 
+dbh_exists(db_handle *dh,
+	   char      *key)
+{
+    if (vlvsiz(dh->dh_vl, key, -1) >= 0)
+	return 1;
+    if (dpecode != DP_ENOITEM){
+	clicon_err(OE_DB, errno, "%s: vlvsiz(%s): %s", 
+		   __FUNCTION__, key, dperrmsg(dpecode));
+	return -1;
+    }
+    return 0;
+}
+
+/*! Return all entries in an open database whose key start with a prefix
+ * Modifications made earlier in the transaction are included.
+ * @param[in]  dh      Database handle from dbh_open
+ * @param[in]  prefix  Prefix of database keys. "" for all keys
+ * @param[in]  label   for memory/chunk allocation
+ * @param[out] pairs   Vector of database keys and values, in key order
+ * @param[in]  noval   If set don't retreive values, just keys
+ * @retval -1  on error   
+ * @retval  n  Number of pairs
+ * @see db_prefix
+ */
+int
+dbh_prefix(db_handle       *dh,
+	   char            *prefix, 
+	   const char      *label, 
+	   struct db_pair **pairs,
+	   int              noval)
+{
+    return db_cursor_prefix(dh->dh_vl, prefix, label, pairs, noval);
+}
+
 /*! Sanitize regexp string. Escape '\' etc.
  */
 char *
@@ -540,7 +860,7 @@ main(int argc, char **argv)
     char  *key;
     char  *val;
     size_t len;
-    DEPOT *dp;
+    VILLA *vl;
 
     if (argc < 3)
 	usage(argv[0]);
@@ -565,7 +885,7 @@ main(int argc, char **argv)
 	db_set(filename, key, val, strlen(val)+1);
     }
     else if (strcmp(verb, "openread")==0){
-	if ((dp = dpopen(filename, DP_OREADER | DP_OLCKNB, 0)) == NULL){
+	if ((vl = vlopen(filename, VL_OREADER | VL_OLCKNB, VL_CMPLEX)) == NULL){
 	    clicon_err(OE_DB, errno, "dbopen: %s", 
 		       dperrmsg(dpecode));
 	    return -1;
@@ -573,7 +893,7 @@ main(int argc, char **argv)
 	sleep(1000000);
     }
     else if (strcmp(verb, "openwrite")==0){
-	if ((dp = dpopen(filename, DP_OWRITER | DP_OLCKNB, 0)) == NULL){
+	if ((vl = vlopen(filename, VL_OWRITER | VL_OLCKNB, VL_CMPLEX)) == NULL){
 	    clicon_err(OE_DB, errno, "dbopen: %s", 
 		       dperrmsg(dpecode));
 	    return -1;
@@ -48,6 +48,9 @@ struct db_pair {
     int   dp_vlen; /* length of vector of lvalues */
 };
 
+/* Open database with a transaction, see dbh_open */
+typedef struct db_handle db_handle;
+
 /*
  * Prototypes
  */ 
@@ -68,6 +71,22 @@ int db_exists(char *file, char *key);
 int db_regexp(char *file, char *regexp, const char *label, 
 	      struct db_pair **pairs, int noval);
 
+int db_prefix(char *file, char *prefix, const char *label, 
+	      struct db_pair **pairs, int noval);
+
+db_handle *dbh_open(char *file);
+
+int dbh_close(db_handle *dh, int commit);
+
+int dbh_set(db_handle *dh, char *key, void *data, size_t datalen);
+
+int dbh_del(db_handle *dh, char *key);
+
+int dbh_exists(db_handle *dh, char *key);
+
+int dbh_prefix(db_handle *dh, char *prefix, const char *label, 
+	       struct db_pair **pairs, int noval);
+
 char *db_sanitize(char *rx, const char *label);
 
 #endif  /* _CLIXON_QDB_H_ */
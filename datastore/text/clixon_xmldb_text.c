@@ -71,7 +71,18 @@ struct text_handle {
     int            th_magic;    /* magic */
     char          *th_dbdir;    /* Directory of database files */
     yang_spec     *th_yangspec; /* Yang spec if this datastore */
-    clicon_hash_t *th_dbs;      /* Hash of databases */
+    clicon_hash_t *th_dbs;      /* Hash of db_elements. key is dbname */
+    int            th_cache;    /* Keep databases parsed in memory so that get
+				   operations need only read memory. Modifications
+				   are written through to file. */
+};
+
+/*! Struct per database in hash 
+ */
+struct db_element{
+    int         de_pid;  /* Process id of locker, 0 if unlocked */
+    cxobj      *de_xml;  /* Cached xml tree (if th_cache), owned by handle */
+    struct stat de_st;   /* File status when de_xml was read or written */
 };
 
 /*! Check struct magic number for sanity checks
@@ -126,6 +137,152 @@ text_db2file(struct text_handle *th,
     return retval;
 }
 
+/*! Get database element of a database, create it if it does not exist
+ * @param[in]   th   text handle handle
+ * @param[in]   db   Symbolic database name, eg "candidate", "running"
+ * @retval      de   Database element, by reference, do not free
+ * @retval      NULL Error
+ */
+static struct db_element *
+text_db_element(struct text_handle *th, 
+		char               *db)
+{
+    struct db_element *de;
+    struct db_element  de0 = {0,};
+
+    if ((de = hash_value(th->th_dbs, db, NULL)) == NULL){
+	if (hash_add(th->th_dbs, db, &de0, sizeof(de0)) == NULL)
+	    return NULL;
+	de = hash_value(th->th_dbs, db, NULL);
+    }
+    return de;
+}
+
+/*! Remove cached xml tree of a database, if any
+ * @param[in]   th   text handle handle
+ * @param[in]   db   Symbolic database name, eg "candidate", "running"
+ */
+static int
+text_db_uncache(struct text_handle *th, 
+		char               *db)
+{
+    struct db_element *de;
+
+    if ((de = hash_value(th->th_dbs, db, NULL)) != NULL && de->de_xml){
+	xml_free(de->de_xml);
+	de->de_xml = NULL;
+    }
+    return 0;
+}
+
+/*! Check if a database file is unchanged since it was last read or written
+ * A file that has been edited or replaced outside the datastore differs in 
+ * inode, size or modification time. The modification time is compared with
+ * nanoseconds, since a file may be written several times within a second.
+ */
+static int
+text_stat_eq(struct stat *st0,
+	     struct stat *st1)
+{
+    return st0->st_ino == st1->st_ino &&
+	st0->st_dev == st1->st_dev &&
+	st0->st_size == st1->st_size &&
+	st0->st_mtim.tv_sec == st1->st_mtim.tv_sec &&
+	st0->st_mtim.tv_nsec == st1->st_mtim.tv_nsec;
+}
+
+/*! Replace a database file with another file atomically
+ * The new file is linked to a temporary name in the database directory, which
+ * is then renamed to the database file. A reader sees either the old or the
+ * new file, and the file content is not copied.
+ * @param[in]  fromfile  Existing file, eg a database file or temporary file
+ * @param[in]  tofile    Database file to replace
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @note Since database files may share inode after this call, they are never
+ *       written in place, but replaced, see text_writefile.
+ */
+static int
+text_linkfile(char *fromfile,
+	      char *tofile)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s.tmp", tofile);
+    if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+	goto done;
+    }
+    if (link(fromfile, cbuf_get(cb)) < 0){
+	clicon_err(OE_UNIX, errno, "link(%s, %s)", fromfile, cbuf_get(cb));
+	goto done;
+    }
+    if (rename(cbuf_get(cb), tofile) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s, %s)", cbuf_get(cb), tofile);
+	unlink(cbuf_get(cb));
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Write a database file by writing a temporary file and renaming it
+ * @param[in]  dbfile  Database file
+ * @param[in]  cb      New content of file
+ * @param[out] st      File status of new file
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see text_linkfile  Database files are replaced, never written in place
+ */
+static int
+text_writefile(char        *dbfile,
+	       cbuf        *cb,
+	       struct stat *st)
+{
+    int   retval = -1;
+    int   fd = -1;
+    cbuf *cbtmp = NULL;
+
+    if ((cbtmp = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cbtmp, "%s.tmp", dbfile);
+    if ((fd = open(cbuf_get(cbtmp), O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU)) < 0) {
+	clicon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cbtmp));
+	goto done;
+    }    
+    if (write(fd, cbuf_get(cb), cbuf_len(cb)) < 0){
+	clicon_err(OE_UNIX, errno, "write(%s)", cbuf_get(cbtmp));
+	goto done;
+    }
+    if (fstat(fd, st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", cbuf_get(cbtmp));
+	goto done;
+    }
+    if (rename(cbuf_get(cbtmp), dbfile) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s, %s)", cbuf_get(cbtmp), dbfile);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (retval < 0 && cbtmp)
+	unlink(cbuf_get(cbtmp));
+    if (cbtmp)
+	cbuf_free(cbtmp);
+    return retval;
+}
+
 /*! Connect to a datastore plugin
  * @retval  handle  Use this handle for other API calls
  * @retval  NULL    Error
@@ -161,12 +318,21 @@ text_disconnect(xmldb_handle xh)
 {
     int                 retval = -1;
     struct text_handle *th = handle(xh);
+    char              **keys;
+    size_t              klen;
+    int                 i;
 
     if (th){
 	if (th->th_dbdir)
 	    free(th->th_dbdir);
-	if (th->th_dbs)
+	if (th->th_dbs){
+	    if ((keys = hash_keys(th->th_dbs, &klen)) != NULL){
+		for(i = 0; i < klen; i++) 
+		    text_db_uncache(th, keys[i]);
+		free(keys);
+	    }
 	    hash_free(th->th_dbs);
+	}
 	free(th);
     }
     retval = 0;
@@ -193,6 +359,8 @@ text_getopt(xmldb_handle xh,
 	*value = th->th_yangspec;
     else if (strcmp(optname, "dbdir") == 0)
 	*value = th->th_dbdir;
+    else if (strcmp(optname, "xml_cache") == 0)
+	*value = (void*)(intptr_t)th->th_cache;
     else{
 	clicon_err(OE_PLUGIN, 0, "Option %s not implemented by plugin", optname);
 	goto done;
@@ -216,6 +384,9 @@ text_setopt(xmldb_handle xh,
 {
     int                 retval = -1;
     struct text_handle *th = handle(xh);
+    char              **keys;
+    size_t              klen;
+    int                 i;
 
     if (strcmp(optname, "yangspec") == 0)
 	th->th_yangspec = (yang_spec*)value;
@@ -225,6 +396,16 @@ text_setopt(xmldb_handle xh,
 	    goto done;
 	}
     }
+    else if (strcmp(optname, "xml_cache") == 0){
+	th->th_cache = (intptr_t)value;
+	if (!th->th_cache){ /* Drop all cached trees */
+	    if ((keys = hash_keys(th->th_dbs, &klen)) != NULL){
+		for(i = 0; i < klen; i++) 
+		    text_db_uncache(th, keys[i]);
+		free(keys);
+	    }
+	}
+    }
     else{
 	clicon_err(OE_PLUGIN, 0, "Option %s not implemented by plugin", optname);
 	goto done;
@@ -273,35 +454,25 @@ singleconfigroot(cxobj  *xt,
     return retval;
 }
 
-/*! Get content of database using xpath. return a set of matching sub-trees
- * The function returns a minimal tree that includes all sub-trees that match
- * xpath.
- * This is a clixon datastore plugin of the the xmldb api
- * @see xmldb_get
+/*! Read a database file and parse it into an xml tree bound to yang spec
+ * @param[in]  th     text handle
+ * @param[in]  dbfile Filename of database
+ * @param[out] xtop   XML tree with top-level "config". Free with xml_free()
+ * @param[out] st     File status at the time of read, if not NULL
+ * @retval     0      OK
+ * @retval    -1      Error
  */
-int
-text_get(xmldb_handle xh,
-	 char         *db, 
-	 char         *xpath,
-	 int           config,
-	 cxobj       **xtop)
+static int
+text_readfile(struct text_handle *th,
+	      char               *dbfile,
+	      cxobj             **xtop,
+	      struct stat        *st)
 {
-    int             retval = -1;
-    char           *dbfile = NULL;
-    yang_spec      *yspec;
-    cxobj          *xt = NULL;
-    int             fd = -1;
-    cxobj         **xvec = NULL;
-    size_t          xlen;
-    int             i;
-    struct text_handle *th = handle(xh);
+    int        retval = -1;
+    yang_spec *yspec;
+    cxobj     *xt = NULL;
+    int        fd = -1;
 
-    if (text_db2file(th, db, &dbfile) < 0)
-	goto done;
-    if (dbfile==NULL){
-	clicon_err(OE_XML, 0, "dbfile NULL");
-	goto done;
-    }
     if ((yspec = th->th_yangspec) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
 	goto done;
@@ -310,6 +481,10 @@ text_get(xmldb_handle xh,
 	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
 	goto done;
     }    
+    if (st && fstat(fd, st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", dbfile);
+	goto done;
+    }    
     /* Parse file into XML tree */
     if ((clicon_xml_parse_file(fd, &xt, "</config>")) < 0)
 	goto done;
@@ -327,13 +502,112 @@ text_get(xmldb_handle xh,
 	    goto done;
     }
     /* Here xt looks like: <config>...</config> */
+    if (strcmp(xml_name(xt),"config")!=0){
+	clicon_err(OE_XML, 0, "Top-level symbol is %s, expected \"config\"",
+		   xml_name(xt));
+	goto done;
+    }
     /* Add yang specification backpointer to all XML nodes */
     if (xml_apply(xt, CX_ELMNT, xml_spec_populate, yspec) < 0)
 	goto done;
+    *xtop = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    if (fd != -1)
+	close(fd);
+    return retval;
+}
+
+/*! Get the xml tree of a database, either from the cache or from file
+ * If the cache is enabled, the cached tree is returned if the file has not
+ * been changed since it was read or written. Otherwise the file is (re-)read 
+ * and the result is cached.
+ * @param[in]  th     text handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[out] xtop   XML tree with top-level "config". If cache is enabled, it
+ *                    belongs to the cache and should not be freed. Otherwise
+ *                    free with xml_free()
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+text_db_tree(struct text_handle *th,
+	     char               *db,
+	     cxobj             **xtop)
+{
+    int                retval = -1;
+    char              *dbfile = NULL;
+    struct db_element *de = NULL;
+    struct stat        st;
+    cxobj             *xt = NULL;
 
-    if (xpath_vec(xt, xpath?xpath:"/", &xvec, &xlen) < 0)
+    if (text_db2file(th, db, &dbfile) < 0)
+	goto done;
+    if (dbfile==NULL){
+	clicon_err(OE_XML, 0, "dbfile NULL");
 	goto done;
+    }
+    if (th->th_cache){
+	if ((de = text_db_element(th, db)) == NULL)
+	    goto done;
+	if (de->de_xml != NULL){
+	    if (stat(dbfile, &st) < 0){
+		clicon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+		goto done;
+	    }
+	    if (text_stat_eq(&st, &de->de_st)){
+		*xtop = de->de_xml;
+		retval = 0;
+		goto done;
+	    }
+	    clicon_debug(1, "%s: %s changed on file, re-read", __FUNCTION__, dbfile);
+	    text_db_uncache(th, db);
+	}
+    }
+    if (text_readfile(th, dbfile, &xt, &st) < 0)
+	goto done;
+    if (de){
+	de->de_xml = xt;
+	de->de_st = st;
+    }
+    *xtop = xt;
+    retval = 0;
+ done:
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
+/*! Get content of database using xpath. return a set of matching sub-trees
+ * The function returns a minimal tree that includes all sub-trees that match
+ * xpath.
+ * If the cache is enabled, the matching parts are copied from the cached tree,
+ * otherwise the tree is read from file and pruned.
+ * This is a clixon datastore plugin of the the xmldb api
+ * @see xmldb_get
+ */
+int
+text_get(xmldb_handle xh,
+	 char         *db, 
+	 char         *xpath,
+	 int           config,
+	 cxobj       **xtop)
+{
+    int             retval = -1;
+    cxobj          *x0t = NULL; /* Database tree, owned by cache if th_cache */
+    cxobj          *xt = NULL;
+    cxobj         **xvec = NULL;
+    size_t          xlen;
+    int             i;
+    struct text_handle *th = handle(xh);
 
+    if (text_db_tree(th, db, &x0t) < 0)
+	goto done;
+    if (xpath_vec(x0t, xpath?xpath:"/", &xvec, &xlen) < 0)
+	goto done;
     /* If vectors are specified then mark the nodes found and
      * then filter out everything else,
      * otherwise return complete tree.
@@ -342,25 +616,43 @@ text_get(xmldb_handle xh,
 	for (i=0; i<xlen; i++)
 	    xml_flag_set(xvec[i], XML_FLAG_MARK);
     }
-    /* Remove everything that is not marked */
-    if (!xml_flag(xt, XML_FLAG_MARK))
-	if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
+    if (th->th_cache){
+	/* Copy the marked parts of the cached tree. Mark ancestors of matches
+	 * so that only paths leading to matches are traversed */
+	for (i=0; i<xlen; i++)
+	    xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, 
+			       (void*)XML_FLAG_CHANGE);
+	if ((xt = xml_new_arena("config")) == NULL)
 	    goto done;
-    /* reset flag */
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
-	goto done;
-    /* filter out state (operations) data if config not set. Mark all nodes
-     that are not config data */
-    if (config && xml_apply(xt, CX_ELMNT, xml_non_config_data, NULL) < 0)
-	goto done;
-    /* Remove (prune) nodes that are marked (that does not pass test) */
-    if (xml_tree_prune_flagged(xt, XML_FLAG_MARK, 1) < 0)
-	goto done;
-    /* Add default values (if not set) */
-    if (xml_apply(xt, CX_ELMNT, xml_default, NULL) < 0)
-	goto done;
-    /* Order XML children according to YANG */
-    if (xml_apply(xt, CX_ELMNT, xml_order, NULL) < 0)
+	if (xml_flag(x0t, XML_FLAG_MARK)){
+	    if (xml_copy(x0t, xt) < 0)
+		goto done;
+	    xml_flag_set(xt, XML_FLAG_MARK);
+	}
+	else if (xml_copy_marked(x0t, xt) < 0)
+	    goto done;
+	xml_arena_close(xt);
+	/* reset flags in cached tree */
+	for (i=0; i<xlen; i++){
+	    xml_flag_reset(xvec[i], XML_FLAG_MARK);
+	    xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_reset, 
+			       (void*)XML_FLAG_CHANGE);
+	}
+	xml_flag_reset(x0t, XML_FLAG_MARK|XML_FLAG_CHANGE);
+    }
+    else{
+	xt = x0t;
+	x0t = NULL;
+	/* Remove everything that is not marked */
+	if (!xml_flag(xt, XML_FLAG_MARK))
+	    if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
+		goto done;
+    }
+    /* In one pass: filter out state data if config is set, add default 
+     * values in the selected (marked) subtrees, order XML children according
+     * to YANG, and reset the marks */
+    if (xml_finalize(xt, (config?XML_FINALIZE_CONFIG:0) | XML_FINALIZE_DEFAULT |
+		     XML_FINALIZE_ORDER | XML_FINALIZE_MARKED) < 0)
 	goto done;
 
     if (debug>1)
@@ -371,12 +663,10 @@ text_get(xmldb_handle xh,
  done:
     if (xt)
 	xml_free(xt);
-    if (dbfile)
-	free(dbfile);
+    if (x0t && !th->th_cache)
+	xml_free(x0t);
     if (xvec)
 	free(xvec);
-    if (fd != -1)
-	close(fd);
     return retval;
 }
 
@@ -394,56 +684,14 @@ match_base_child(cxobj     *x0,
 {
     int        retval = -1;
     cxobj     *x0c = NULL;
-    char      *keyname;
-    cvec      *cvk = NULL;
-    cg_var    *cvi;
-    char      *b0;
-    char      *b1;
-    yang_stmt *ykey;
     char      *cname;
-    int        ok;
-    char      *x1bstr; /* body string */
 
     cname = xml_name(x1c);
     switch (yc->ys_keyword){
     case Y_LEAF_LIST: /* Match with name and value */
-	x1bstr = xml_body(x1c);
-	x0c = NULL;
-	while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
-	    if (strcmp(cname, xml_name(x0c)) == 0 && 
-		strcmp(xml_body(x0c), x1bstr)==0)
-		break;
-	}
-	break;
     case Y_LIST: /* Match with key values */
-	if ((ykey = yang_find((yang_node*)yc, Y_KEY, NULL)) == NULL){
-	    clicon_err(OE_XML, errno, "%s: List statement \"%s\" has no key", 
-		       __FUNCTION__, yc->ys_argument);
-	    goto done;
-	}
-	/* The value is a list of keys: <key>[ <key>]*  */
-	if ((cvk = yang_arg2cvec(ykey, " ")) == NULL)
+	if (xml_find_keyed(x0, x1c, yc, &x0c) < 0)
 	    goto done;
-	x0c = NULL;
-	while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
-	    if (strcmp(xml_name(x0c), cname))
-		continue;
-	    cvi = NULL;
-	    ok = 0;
-	    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-		keyname = cv_string_get(cvi);
-		ok = 1; /* if we come here */
-		if ((b0 = xml_find_body(x0c, keyname)) == NULL)
-		    break; /* error case */
-		if ((b1 = xml_find_body(x1c, keyname)) == NULL)
-		    break; /* error case */
-		if (strcmp(b0, b1))
-		    break;
-		ok = 2; /* and reaches here for all keynames, x0c is found. */
-	    }
-	    if (ok == 2)
-		break;
-	}
 	break;
     default: /* Just match with name */
 	x0c = xml_find(x0, cname);
@@ -452,8 +700,6 @@ match_base_child(cxobj     *x0,
     *x0cp = x0c;
     retval = 0;
  done:
-    if (cvk)
-	cvec_free(cvk);
     return retval;
 }
 
@@ -732,10 +978,11 @@ text_put(xmldb_handle        xh,
     int                 retval = -1;
     struct text_handle *th = handle(xh);
     char               *dbfile = NULL;
-    int                 fd = -1;
     cbuf               *cb = NULL;
     yang_spec          *yspec;
-    cxobj              *x0 = NULL;
+    cxobj              *x0 = NULL; /* Database tree, owned by cache if th_cache */
+    struct db_element  *de;
+    struct stat         st;
 
     if (text_db2file(th, db, &dbfile) < 0)
 	goto done;
@@ -752,36 +999,9 @@ text_put(xmldb_handle        xh,
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
 	goto done;
     }
-    if ((fd = open(dbfile, O_RDONLY)) < 0) {
-	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
+    /* Get base tree x0 as: <config>...</config> */
+    if (text_db_tree(th, db, &x0) < 0)
 	goto done;
-    }    
-    /* Parse file into XML tree */
-    if ((clicon_xml_parse_file(fd, &x0, "</config>")) < 0)
-	goto done;
-    /* Always assert a top-level called "config". 
-       To ensure that, deal with two cases:
-       1. File is empty <top/> -> rename top-level to "config" */
-    if (xml_child_nr(x0) == 0){ 
-	if (xml_name_set(x0, "config") < 0)
-	    goto done;     
-    }
-    /* 2. File is not empty <top><config>...</config></top> -> replace root */
-    else{ 
-	/* There should only be one element and called config */
-	if (singleconfigroot(x0, &x0) < 0)
-	    goto done;
-    }
-    /* Here x0 looks like: <config>...</config> */
-    if (strcmp(xml_name(x0),"config")!=0){
-	clicon_err(OE_XML, 0, "Top-level symbol is %s, expected \"config\"",
-		   xml_name(x0));
-	goto done;
-    }
-
-    /* Add yang specification backpointer to all XML nodes */
-    if (xml_apply(x0, CX_ELMNT, xml_spec_populate, yspec) < 0)
-       goto done;
 
     /* Add yang specification backpointer to all XML nodes */
     if (xml_apply(x1, CX_ELMNT, xml_spec_populate, yspec) < 0)
@@ -813,25 +1033,25 @@ text_put(xmldb_handle        xh,
     }
     if (clicon_xml2cbuf(cb, x0, 0, 1) < 0)
 	goto done;
-    /* Reopen file in write mode */
-    close(fd);
-    if ((fd = open(dbfile, O_WRONLY | O_TRUNC, S_IRWXU)) < 0) {
-	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
-	goto done;
-    }    
-    if (write(fd, cbuf_get(cb), cbuf_len(cb)) < 0){
-	clicon_err(OE_UNIX, errno, "write(%s)", dbfile);
+    /* Replace file, it may share inode with another database */
+    if (text_writefile(dbfile, cb, &st) < 0)
 	goto done;
+    /* Cache is written through, remember file status to detect later changes */
+    if (th->th_cache){
+	if ((de = text_db_element(th, db)) == NULL)
+	    goto done;
+	de->de_st = st;
     }
     retval = 0;
  done:
+    /* If cached tree may be inconsistent with file, re-read it next time */
+    if (retval < 0 && th->th_cache)
+	text_db_uncache(th, db);
     if (dbfile)
 	free(dbfile);
-    if (fd != -1)
-	close(fd);
     if (cb)
 	cbuf_free(cb);
-    if (x0)
+    if (x0 && !th->th_cache)
 	xml_free(x0);
     return retval;
 }
@@ -852,14 +1072,85 @@ text_copy(xmldb_handle xh,
     struct text_handle *th = handle(xh);
     char               *fromfile = NULL;
     char               *tofile = NULL;
+    cxobj              *x0 = NULL;
+    struct db_element  *de;
 
     /* XXX lock */
     if (text_db2file(th, from, &fromfile) < 0)
 	goto done;
     if (text_db2file(th, to, &tofile) < 0)
 	goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    /* Ensure cached source tree is in sync with source file before copying */
+    if (th->th_cache && text_db_tree(th, from, &x0) < 0)
 	goto done;
+    if (text_linkfile(fromfile, tofile) < 0)
+	goto done;
+    if (th->th_cache){
+	/* Replace cached destination tree with a copy of the source tree */
+	text_db_uncache(th, to);
+	if ((de = text_db_element(th, to)) == NULL)
+	    goto done;
+	if (stat(tofile, &de->de_st) < 0){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", tofile);
+	    goto done;
+	}
+	if ((de->de_xml = xml_dup(x0)) == NULL)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (fromfile)
+	free(fromfile);
+    if (tofile)
+	free(tofile);
+    return retval;
+}
+
+/*! Promote database from to database to, eg candidate to running
+ * The file of to is atomically replaced by the file of from, without copying
+ * the content. If the cache is enabled, the cached tree of from is moved to
+ * to, and from is read from file when next used.
+ * @param[in]  xh    XMLDB handle
+ * @param[in]  from  Source database, eg "candidate". Not changed
+ * @param[in]  to    Destination database, eg "running"
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see text_copy
+ */
+int 
+text_commit(xmldb_handle xh, 
+	    char        *from,
+	    char        *to)
+{
+    int                 retval = -1;
+    struct text_handle *th = handle(xh);
+    char               *fromfile = NULL;
+    char               *tofile = NULL;
+    cxobj              *x0 = NULL;
+    struct db_element  *de;
+
+    if (text_db2file(th, from, &fromfile) < 0)
+	goto done;
+    if (text_db2file(th, to, &tofile) < 0)
+	goto done;
+    /* Ensure cached source tree is in sync with source file */
+    if (th->th_cache && text_db_tree(th, from, &x0) < 0)
+	goto done;
+    if (text_linkfile(fromfile, tofile) < 0)
+	goto done;
+    if (th->th_cache){
+	text_db_uncache(th, to);
+	if ((de = text_db_element(th, to)) == NULL)
+	    goto done;
+	if (stat(tofile, &de->de_st) < 0){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", tofile);
+	    goto done;
+	}
+	de->de_xml = x0;
+	if ((de = text_db_element(th, from)) == NULL)
+	    goto done;
+	de->de_xml = NULL;
+    }
     retval = 0;
  done:
     if (fromfile)
@@ -882,8 +1173,11 @@ text_lock(xmldb_handle xh,
 	  int          pid)
 {
     struct text_handle *th = handle(xh);
+    struct db_element  *de;
 
-    hash_add(th->th_dbs, db, &pid, sizeof(pid));
+    if ((de = text_db_element(th, db)) == NULL)
+	return -1;
+    de->de_pid = pid;
     clicon_debug(1, "%s: locked by %u",  db, pid);
     return 0;
 }
@@ -901,10 +1195,10 @@ text_unlock(xmldb_handle xh,
 	    char        *db)
 {
     struct text_handle *th = handle(xh);
-    int zero = 0;
+    struct db_element  *de;
 
-    hash_add(th->th_dbs, db, &zero, sizeof(zero));
-    //	    hash_del(th->th_dbs, db);
+    if ((de = hash_value(th->th_dbs, db, NULL)) != NULL)
+	de->de_pid = 0;
     return 0;
 }
 
@@ -922,15 +1216,15 @@ text_unlock_all(xmldb_handle xh,
     char              **keys;
     size_t              klen;
     int                 i;
-    int                *val;
-    size_t              vlen;
+    struct db_element  *de;
 
     if ((keys = hash_keys(th->th_dbs, &klen)) == NULL)
 	return 0;
     for(i = 0; i < klen; i++) 
-	if ((val = hash_value(th->th_dbs, keys[i], &vlen)) != NULL &&
-	    *val == pid)
-	    hash_del(th->th_dbs, keys[i]);
+	if ((de = hash_value(th->th_dbs, keys[i], NULL)) != NULL &&
+	    de->de_pid == pid)
+	    de->de_pid = 0;
+    free(keys);
     return 0;
 }
 
@@ -946,13 +1240,11 @@ text_islocked(xmldb_handle xh,
 	    char          *db)
 {
     struct text_handle *th = handle(xh);
-    size_t              vlen;
-    int                *val;
+    struct db_element  *de;
 
-    if ((val = hash_value(th->th_dbs, db, &vlen)) == NULL)
+    if ((de = hash_value(th->th_dbs, db, NULL)) == NULL)
 	return 0;
-    return *val;
-    return 0;
+    return de->de_pid;
 }
 
 /*! Check if db exists 
@@ -1000,6 +1292,7 @@ text_delete(xmldb_handle xh,
 
     if (text_db2file(th, db, &filename) < 0)
 	goto done;
+    text_db_uncache(th, db);
     if (unlink(filename) < 0){
 	clicon_err(OE_DB, errno, "unlink %s", filename);
 	goto done;
@@ -1066,7 +1359,7 @@ clixon_xmldb_plugin_init(int version)
 }
 
 static const struct xmldb_api api = {
-    1,
+    XMLDB_API_VERSION,
     XMLDB_API_MAGIC,
     clixon_xmldb_plugin_init,
     text_plugin_exit,
@@ -1084,6 +1377,7 @@ static const struct xmldb_api api = {
     text_exists,
     text_delete,
     text_create,
+    text_commit,
 };
 
 
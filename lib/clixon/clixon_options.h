@@ -107,6 +107,7 @@ int   clicon_cli_varonly_set(clicon_handle h, int val);
 int   clicon_cli_genmodel_completion(clicon_handle h);
 
 char *clicon_xmldb_dir(clicon_handle h);
+int   clicon_xmldb_cache(clicon_handle h);
 
 char *clicon_quiet_mode(clicon_handle h);
 enum genmodel_type clicon_cli_genmodel_type(clicon_handle h);
@@ -132,4 +133,8 @@ int clicon_xmldb_handle_set(clicon_handle h, void *xh);
 
 void *clicon_xmldb_handle_get(clicon_handle h);
 
+int clicon_client_socket_set(clicon_handle h, int s);
+
+int clicon_client_socket_get(clicon_handle h);
+
 #endif  /* _CLIXON_OPTIONS_H_ */
@@ -49,9 +49,28 @@ enum format_enum{
     FORMAT_NETCONF
 };
 
-/* Protocol message header */
+/* Current version of protocol message header */
+#define CLICON_MSG_VERSION 2
+
+/* Max length of a received message (incl header). Longer messages are 
+ * rejected before the body is allocated */
+#define CLICON_MSG_MAXLEN (256*1024*1024)
+
+/* Protocol message header (version 2)
+ * A version 1 header, used by earlier releases, is only a uint16_t length
+ * (incl header), which limits messages to 64K. A version 2 header starts 
+ * with a zero word, which is never a valid version 1 length, followed by 
+ * the version. Received version 1 messages are converted to this header 
+ * with request id 0, and replies are sent in the version of the request, 
+ * so that old clients still work.
+ * All fields are in network byte order.
+ */
 struct clicon_msg {
-    uint16_t    op_len;      /* length of message. */
+    uint16_t    op_zero;     /* always 0, distinguishes from version 1 */
+    uint16_t    op_version;  /* header version on the wire, 1 or 2 */
+    uint32_t    op_len;      /* length of message incl header. */
+    uint16_t    op_id;       /* request id, echoed by backend in reply */
+    uint16_t    op_pad;
     char        op_body[0];  /* rest of message, actual data */
 };
 
@@ -66,6 +85,8 @@ int clicon_msg_decode(struct clicon_msg *msg, cxobj **xml);
 
 int clicon_connect_unix(char *sockpath);
 
+int clicon_connect_inet(char *dst, uint16_t port);
+
 int clicon_rpc_connect_unix(struct clicon_msg    *msg, 
 			    char                 *sockpath,
 			    char                **ret,
@@ -83,9 +104,12 @@ int clicon_msg_send(int s, struct clicon_msg *msg);
 
 int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
 
-int send_msg_notify(int s, int level, char *event);
+int send_msg_notify(int s, uint16_t version, int level, char *event);
+
+int send_msg_reply(int s, struct clicon_msg *req, char *data, uint32_t datalen);
 
-int send_msg_reply(int s, char *data, uint16_t datalen);
+int send_msg_reply_xml(int s, struct clicon_msg *req, char *pre, cxobj *xt, 
+		       char *post);
 
 int detect_endtag(char *tag, char  ch, int  *state);
 
@@ -40,6 +40,9 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+int clicon_rpc_session_close(clicon_handle h);
+int clicon_rpc_msg_send(clicon_handle h, struct clicon_msg *msg, uint16_t *id);
+int clicon_rpc_msg_recv(clicon_handle h, uint16_t id, cxobj **xret0);
 int clicon_rpc_msg(clicon_handle h, struct clicon_msg *msg, cxobj **xret0,
 		   int *sock0);
 int clicon_rpc_netconf(clicon_handle h, char *xmlst, cxobj **xret, int *sp);
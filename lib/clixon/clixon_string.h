@@ -78,6 +78,8 @@ int percent_encode(char *str, char **escp);
 int percent_decode(char *esc, char **str);
 const char *clicon_int2str(const map_str2int *mstab, int i);
 int clicon_str2int(const map_str2int *mstab, char *str);
+char *clicon_intern(char *str);
+char *clicon_intern_find(char *str);
 
 #ifndef HAVE_STRNDUP
 char *clicon_strndup (const char *, size_t);
@@ -57,6 +57,8 @@ enum cxobj_type {CX_ERROR=-1,
 
 typedef struct xml cxobj; /* struct defined in clicon_xml.c */
 
+typedef struct xml_stream xml_stream; /* struct defined in clicon_xml.c */
+
 /*! Callback function type for xml_apply */
 typedef int (xml_applyfn_t)(cxobj *yn, void *arg);
 
@@ -74,6 +76,7 @@ typedef int (xml_applyfn_t)(cxobj *yn, void *arg);
  */
 char     *xml_type2str(enum cxobj_type type);
 char     *xml_name(cxobj *xn);
+int       xml_name_eq(cxobj *xn, char *name, char *iname);
 int       xml_name_set(cxobj *xn, char *name);
 char     *xml_namespace(cxobj *xn);
 int       xml_namespace_set(cxobj *xn, char *name);
@@ -102,9 +105,14 @@ cxobj    *xml_child_each(cxobj *xparent, cxobj *xprev,  enum cxobj_type type);
 cxobj   **xml_childvec_get(cxobj *x);
 int       xml_childvec_set(cxobj *x, int len);
 cxobj    *xml_new(char *name, cxobj *xn_parent);
+cxobj    *xml_new_arena(char *name);
+int       xml_arena_close(cxobj *x);
 cxobj    *xml_new_spec(char *name, cxobj *xn_parent, void *spec);
 void     *xml_spec(cxobj *x);
 void     *xml_spec_set(cxobj *x, void *spec);
+int       xml_find_keyindex(cxobj *xp, cxobj *x1, cvec *keys, cxobj **xmatch);
+int       xml_find_descendants(cxobj *xt, char *name, cxobj ***vec, size_t *veclen);
+uint64_t  xml_hash(cxobj *x);
 cxobj    *xml_find(cxobj *xn_parent, char *name);
 
 int       xml_addsub(cxobj *xp, cxobj *xc);
@@ -124,6 +132,12 @@ int       xml_free(cxobj *xn);
 int       xml_print(FILE  *f, cxobj *xn);
 int       clicon_xml2file(FILE *f, cxobj *xn, int level, int prettyprint);
 int       clicon_xml2cbuf(cbuf *xf, cxobj *xn, int level, int prettyprint);
+xml_stream *xml_stream_new(int fd);
+int       xml_stream_free(xml_stream *xs);
+size_t    xml_stream_len(xml_stream *xs);
+int       xml_stream_str(xml_stream *xs, char *str, size_t len);
+int       xml_stream_flush(xml_stream *xs);
+int       clicon_xml2stream(xml_stream *xs, cxobj *xn, int level, int prettyprint);
 int       clicon_xml_parse_file(int fd, cxobj **xml_top, char *endtag);
 /* XXX obsolete */
 #define clicon_xml_parse_string(str, x) clicon_xml_parse_str((*str), x) 
@@ -48,7 +48,7 @@ typedef void *xmldb_handle;
 #endif
 
 /* Version of clixon datastore plugin API. */
-#define XMLDB_API_VERSION 1
+#define XMLDB_API_VERSION 2 /* 2: xa_commit_fn */
 
 /* Magic to ensure plugin sanity. */
 #define XMLDB_API_MAGIC 0xf386f730
@@ -104,6 +104,9 @@ typedef int (xmldb_delete_t)(xmldb_handle xh, char *db);
 /* Type of xmldb init function */
 typedef int (xmldb_create_t)(xmldb_handle xh, char *db);
 
+/* Type of xmldb commit function */
+typedef int (xmldb_commit_t)(xmldb_handle xh, char *from, char *to);
+
 /* plugin init struct for the api */
 struct xmldb_api{
     int                 xa_version;
@@ -124,6 +127,7 @@ struct xmldb_api{
     xmldb_exists_t     *xa_exists_fn;
     xmldb_delete_t     *xa_delete_fn;
     xmldb_create_t     *xa_create_fn;
+    xmldb_commit_t     *xa_commit_fn;  /* Optional, xa_copy_fn is used if NULL */
 };
 
 /*
@@ -141,6 +145,7 @@ int xmldb_setopt(clicon_handle h, char *optname, void *value);
 int xmldb_get(clicon_handle h, char *db, char *xpath, int config, cxobj **xtop);
 int xmldb_put(clicon_handle h, char *db, enum operation_type op, cxobj *xt);
 int xmldb_copy(clicon_handle h, char *from, char *to);
+int xmldb_commit(clicon_handle h, char *from, char *to);
 int xmldb_lock(clicon_handle h, char *db, int pid);
 int xmldb_unlock(clicon_handle h, char *db);
 int xmldb_unlock_all(clicon_handle h, int pid);
@@ -148,5 +153,6 @@ int xmldb_islocked(clicon_handle h, char *db);
 int xmldb_exists(clicon_handle h, char *db);
 int xmldb_delete(clicon_handle h, char *db);
 int xmldb_create(clicon_handle h, char *db);
+uint32_t xmldb_generation(clicon_handle h, char *db);
 
 #endif /* _CLIXON_XML_DB_H */
@@ -38,6 +38,14 @@
 #ifndef _CLIXON_XML_MAP_H_
 #define _CLIXON_XML_MAP_H_
 
+/* Operations of xml_finalize */
+#define XML_FINALIZE_CONFIG  0x01 /* Remove state data, ie config false */
+#define XML_FINALIZE_DEFAULT 0x02 /* Add default values, see xml_default */
+#define XML_FINALIZE_ORDER   0x04 /* Order children, see xml_order */
+#define XML_FINALIZE_SANITY  0x08 /* Check names with yang, see xml_sanity */
+#define XML_FINALIZE_MARKED  0x10 /* Add defaults only in XML_FLAG_MARK:ed
+				     subtrees. Resets the flag */
+
 /*
  * Prototypes
  */
@@ -56,11 +64,14 @@ int api_path_fmt2api_path(char *api_path_fmt, cvec *cvv, char **api_path);
 int api_path_fmt2xpath(char *api_path_fmt, cvec *cvv, char **xpath);
 int xml_tree_prune_flagged_sub(cxobj *xt, int flag, int test, int *upmark);
 int xml_tree_prune_flagged(cxobj *xt, int flag, int test);
+int xml_copy_marked(cxobj *x0, cxobj *x1);
+int xml_find_keyed(cxobj *xp, cxobj *x1, yang_stmt *y, cxobj **xmatch);
 int xml_default(cxobj *x, void  *arg);
 int xml_order(cxobj *x, void  *arg);
 int xml_sanity(cxobj *x, void  *arg);
 int xml_non_config_data(cxobj *xt, void *arg);
 int xml_spec_populate(cxobj *x, void *arg);
+int xml_finalize(cxobj *xt, int ops);
 int api_path2xpath_cvv(yang_spec *yspec, cvec *cvv, int offset, cbuf *xpath);
 int api_path2xpath(yang_spec *yspec, char *api_path, cbuf *xpath);
 int api_path2xml(char *api_path, yang_spec *yspec, cxobj *xtop, 
@@ -36,9 +36,18 @@
 #ifndef _CLIXON_XSL_H
 #define _CLIXON_XSL_H
 
+/*
+ * Types
+ */
+typedef struct xpath_comp xpath_comp; /* Compiled xpath */
+
 /*
  * Prototypes
  */
+xpath_comp *xpath_compile(char *xpath);
+int xpath_comp_free(xpath_comp *xc);
+int xpath_vec_compiled(cxobj *xcur, xpath_comp *xc, uint16_t flags,
+		       cxobj ***vec, size_t *veclen);
 cxobj *xpath_first(cxobj *cxtop, char *format, ...);
 cxobj *xpath_each(cxobj *xn_top, char *xpath, cxobj *prev);
 int xpath_vec(cxobj *cxtop, char *format, cxobj ***vec, size_t  *veclen, ...);
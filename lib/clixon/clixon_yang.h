@@ -123,6 +123,10 @@ enum rfc_6020{
 };
 
 #define YANG_FLAG_MARK 0x01  /* Marker for dynamic algorithms, eg expand */
+#define YANG_FLAG_LEAFREF 0x02  /* Node may be target of a leafref path. If set
+				  in yang spec, any node may be a target */
+#define YANG_FLAG_INTERN 0x04  /* ys_argument is interned, see clicon_intern.
+				  Not freed. Set for schema nodes */
 
 /* Yang data node */
 #define yang_datanode(y) ((y)->ys_keyword == Y_CONTAINER || (y)->ys_keyword == Y_LEAF || (y)->ys_keyword == Y_LIST || (y)->ys_keyword == Y_LEAF_LIST || (y)->ys_keyword == Y_ANYXML)
@@ -133,18 +137,34 @@ enum rfc_6020{
 typedef struct yang_stmt yang_stmt; /* forward */
 
 /*! Yang type cache. Yang type statements can cache all typedef info here
- * @note unions not cached
+ * @note union member types are cached in their own type statements
 */
 struct yang_type_cache{
     int        yc_options;
     cg_var    *yc_mincv;
     cg_var    *yc_maxcv;
     char      *yc_pattern;
+    void      *yc_regex;    /* Compiled yc_pattern (regex_t*), or NULL */
     uint8_t    yc_fraction;
     yang_stmt *yc_resolved; /* Resolved type object, can be NULL - note direct ptr */
 };
 typedef struct yang_type_cache yang_type_cache;
 
+typedef struct yang_index yang_index; /* struct defined in clixon_yang.c */
+
+/*! Data node tables of a yang node, precomputed for xml_default and xml_order
+ * Built on demand, see yang_datatab_get
+ */
+struct yang_datatab{
+    int         yt_len;      /* Nr of data node children, choice/case flattened.
+				Each has its position in ys_order */
+    int         yt_deflen;   /* Nr of leaf children with default values */
+    yang_stmt **yt_defleaf;  /* Leaf children with default values, yang order */
+    char      **yt_defbody;  /* Default values of yt_defleaf as xml bodies */
+    int        *yt_defidx;   /* Position -> index in yt_defleaf, or -1 */
+};
+typedef struct yang_datatab yang_datatab;
+
 /*! yang statement 
  */
 struct yang_stmt{
@@ -155,11 +175,15 @@ struct yang_stmt{
 
     char              *ys_argument;  /* String / argument depending on keyword */   
     int                ys_flags;     /* Flags according to YANG_FLAG_* above */
+    yang_index        *ys_index;     /* Name index of children, see yang_find */
     cg_var            *ys_cv;        /* cligen variable. The following stmts have cvs::
 				        leaf, leaf-list, mandatory, fraction-digits */
     cvec              *ys_cvec;      /* List of stmt-specific variables 
 					Y_RANGE: range_min, range_max */
     yang_type_cache   *ys_typecache; /* If ys_keyword==Y_TYPE, cache all typedef data except unions */
+    yang_datatab      *ys_datatab;   /* Data node tables, see yang_datatab_get */
+    int                ys_order;     /* Position among data nodes of parent 
+					data node, see yang_order */
 };
 
 
@@ -171,6 +195,7 @@ struct yang_spec{
     enum rfc_6020      yp_keyword;   /* SHOULD BE Y_SPEC */
     char              *yp_argument;  /* XXX String / argument depending on keyword */   
     int                yp_flags;     /* Flags according to YANG_FLAG_* above */
+    yang_index        *yp_index;     /* Name index of children, see yang_find */
 };
 typedef struct yang_spec yang_spec;
 
@@ -182,6 +207,7 @@ struct yang_node{
     enum rfc_6020      yn_keyword;   /* See clicon_yang_parse.tab.h */
     char              *yn_argument;  /* XXX String / argument depending on keyword */   
     int                yn_flags;     /* Flags according to YANG_FLAG_* above */
+    yang_index        *yn_index;     /* Name index of children, see yang_find */
 };
 typedef struct yang_node yang_node;
 
@@ -222,9 +248,13 @@ int        yang_desc_schema_nodeid(yang_node *yn, char *schema_nodeid,
 cg_var    *ys_parse(yang_stmt *ys, enum cv_type cvtype);
 int        ys_parse_sub(yang_stmt *ys);
 int        yang_mandatory(yang_stmt *ys);
+int        yang_leafref_target(yang_stmt *ys);
 int        yang_config(yang_stmt *ys);
 int        yang_spec_main(clicon_handle h, FILE *f, int printspec);
 cvec      *yang_arg2cvec(yang_stmt *ys, char *delimi);
+cvec      *yang_key_cvec(yang_stmt *ys);
 int        yang_key_match(yang_node *yn, char *name);
+yang_datatab *yang_datatab_get(yang_stmt *ys);
+int        yang_order(yang_stmt *ys, yang_stmt *yc);
 
 #endif  /* _CLIXON_YANG_H_ */
@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <limits.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -49,6 +50,11 @@
 #include <syslog.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <sys/select.h>
+#endif
 
 #include "clixon_queue.h"
 #include "clixon_log.h"
@@ -59,16 +65,19 @@
  * Constants
  */
 #define EVENT_STRLEN 32
+#define EVENT_FDHASH 1024 /* Nr of buckets in fd table, power of 2 */
+#define EVENT_MAXFDS 64   /* Max nr of ready fds handled per loop */
 
 /*
  * Types
  */
 struct event_data{
-    struct event_data *e_next;     /* next in list */
+    struct event_data *e_next;     /* next in fd hash bucket */
     int (*e_fn)(int, void*);            /* function */
     enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
     int e_fd;                      /* File descriptor */
     struct timeval e_time;         /* Timeout */
+    unsigned int e_seq;            /* Timeout registration order, for equal times */
     void *e_arg;                   /* function argument */
     char e_string[EVENT_STRLEN];             /* string for debugging */
 };
@@ -76,8 +85,20 @@ struct event_data{
 /*
  * Internal variables
  */
-static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+/* File descriptor events hashed on fd */
+static struct event_data *ee[EVENT_FDHASH] = {NULL,};
+
+/* Timeouts in a binary min-heap ordered on time (and registration order) */
+static struct event_data **ee_timers = NULL;
+static int ee_timers_len = 0;    /* Nr of timeouts in heap */
+static int ee_timers_size = 0;   /* Allocated size of heap */
+static unsigned int ee_timers_seq = 0;
+/* Expired timeouts removed from heap, to be called in this loop, in time order */
+static struct event_data *ee_expired = NULL;
+
+#ifdef HAVE_SYS_EPOLL_H
+static int _ee_epfd = -1;        /* epoll instance, created at first fd registration */
+#endif
 
 /* Set if element in ee is deleted (event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
@@ -104,6 +125,19 @@ clicon_exit_get(void)
     return _clicon_exit;
 }
 
+/*! Check if there is any registration of a file descriptor
+ */
+static int
+event_fd_registered(int fd)
+{
+    struct event_data *e;
+
+    for (e = ee[fd & (EVENT_FDHASH-1)]; e; e = e->e_next)
+	if (e->e_fd == fd)
+	    return 1;
+    return 0;
+}
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd  File descriptor
@@ -123,7 +157,31 @@ event_reg_fd(int   fd,
 	     char *str)
 {
     struct event_data *e;
+    struct event_data **eb;
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev;
+#endif
 
+#ifdef HAVE_SYS_EPOLL_H
+    if (_ee_epfd == -1 &&
+	(_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_create1");
+	return -1;
+    }
+    /* Add also if registered: fd may have been closed and reused */
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(_ee_epfd, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST){
+	clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	return -1;
+    }
+#else
+    if (fd >= FD_SETSIZE){
+	clicon_err(OE_EVENTS, EINVAL, "fd %d >= FD_SETSIZE", fd);
+	return -1;
+    }
+#endif
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
@@ -134,8 +192,9 @@ event_reg_fd(int   fd,
     e->e_fn = fn;
     e->e_arg = arg;
     e->e_type = EVENT_FD;
-    e->e_next = ee;
-    ee = e;
+    eb = &ee[fd & (EVENT_FDHASH-1)];
+    e->e_next = *eb;
+    *eb = e;
     clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
     return 0;
 }
@@ -154,8 +213,8 @@ event_unreg_fd(int   s,
     struct event_data *e, **e_prev;
     int found = 0;
 
-    e_prev = &ee;
-    for (e = ee; e; e = e->e_next){
+    e_prev = &ee[s & (EVENT_FDHASH-1)];
+    for (e = *e_prev; e; e = e->e_next){
 	if (fn == e->e_fn && s == e->e_fd) {
 	    found++;
 	    *e_prev = e->e_next;
@@ -165,9 +224,62 @@ event_unreg_fd(int   s,
 	}
 	e_prev = &e->e_next;
     }
+#ifdef HAVE_SYS_EPOLL_H
+    /* Fd may already be closed (and thereby removed from epoll), ignore errors */
+    if (found && !event_fd_registered(s))
+	epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, s, NULL);
+#endif
     return found?0:-1;
 }
 
+/*! Timeout e0 is before e1 
+ */
+static int
+event_timer_before(struct event_data *e0,
+		   struct event_data *e1)
+{
+    if (timercmp(&e0->e_time, &e1->e_time, ==))
+	return (int)(e0->e_seq - e1->e_seq) < 0;
+    return timercmp(&e0->e_time, &e1->e_time, <);
+}
+
+/*! Move timeout at heap position i up or down to its place in the heap
+ */
+static void
+event_timer_sift(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                j;
+
+    while (i > 0 && event_timer_before(e, ee_timers[(i-1)/2])){ /* up */
+	ee_timers[i] = ee_timers[(i-1)/2];
+	i = (i-1)/2;
+    }
+    while ((j = 2*i+1) < ee_timers_len){ /* down */
+	if (j+1 < ee_timers_len && event_timer_before(ee_timers[j+1], ee_timers[j]))
+	    j++;
+	if (!event_timer_before(ee_timers[j], e))
+	    break;
+	ee_timers[i] = ee_timers[j];
+	i = j;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Remove timeout at heap position i and return it
+ */
+static struct event_data *
+event_timer_rm(int i)
+{
+    struct event_data *e = ee_timers[i];
+
+    if (--ee_timers_len > i){
+	ee_timers[i] = ee_timers[ee_timers_len];
+	event_timer_sift(i);
+    }
+    return e;
+}
+
 /*! Call a callback function at an absolute time
  * @param[in]  t   Absolute (not relative!) timestamp when callback is called
  * @param[in]  fn  Function to call at time t
@@ -197,8 +309,19 @@ event_reg_timeout(struct timeval t,
 		  void          *arg, 
 		  char          *str)
 {
-    struct event_data *e, *e1, **e_prev;
+    struct event_data  *e;
+    struct event_data **vec;
+    int                 size;
 
+    if (ee_timers_len == ee_timers_size){
+	size = ee_timers_size?2*ee_timers_size:16;
+	if ((vec = realloc(ee_timers, size*sizeof(struct event_data *))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	ee_timers = vec;
+	ee_timers_size = size;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
@@ -209,15 +332,10 @@ event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
+    e->e_seq = ee_timers_seq++;
     /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-	if (timercmp(&e->e_time, &e1->e_time, <))
-	    break;
-	e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
+    ee_timers[ee_timers_len++] = e;
+    event_timer_sift(ee_timers_len-1);
     clicon_debug(2, "event_reg_timeout: %s", str); 
     return 0;
 }
@@ -226,6 +344,8 @@ event_reg_timeout(struct timeval t,
  * Note: deregister when exactly function and function arguments match, not time. So you
  * cannot have same function and argument callback on different timeouts. This is a little
  * different from event_unreg_fd.
+ * A timeout that has expired but not yet been called, eg when another timeout
+ * callback of the same loop deregisters it, is also removed.
  * @param[in]  fn  Function to call at time t
  * @param[in]  arg Argument to function fn
  * @see event_reg_timeout
@@ -235,50 +355,107 @@ int
 event_unreg_timeout(int (*fn)(int, void*), 
 		    void *arg)
 {
-    struct event_data *e, **e_prev;
+    struct event_data  *e;
+    struct event_data **e_prev;
+    int i;
     int found = 0;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
+    for (i = 0; i < ee_timers_len; i++){
+	e = ee_timers[i];
+	if (fn == e->e_fn && arg == e->e_arg) {
+	    found++;
+	    free(event_timer_rm(i));
+	    break;
+	}
+    }
+    for (e_prev = &ee_expired; !found && (e = *e_prev) != NULL; e_prev = &e->e_next)
 	if (fn == e->e_fn && arg == e->e_arg) {
 	    found++;
 	    *e_prev = e->e_next;
 	    free(e);
 	    break;
 	}
-	e_prev = &e->e_next;
-    }
     return found?0:-1;
 }
 
-/*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
- * There is an issue with fairness that timeouts may take over all events
- * One could try to poll the file descriptors after a timeout?
+/*! Wait for input on registered file descriptors or until timeout
+ * @param[in]  tp    Max time to wait, or NULL to wait forever
+ * @param[out] fds   Vector of file descriptors with input, EVENT_MAXFDS long
+ * @retval     n     Nr of file descriptors in fds
+ * @retval    -1     Error, errno set
+ */
+static int
+event_poll(struct timeval *tp,
+	   int            *fds)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event evs[EVENT_MAXFDS];
+    int                ms = -1;
+    int                n;
+    int                i;
+
+    if (tp){ /* Round up so that timeout has passed when returning */
+	if (tp->tv_sec > INT_MAX/1000 - 1)
+	    ms = INT_MAX;
+	else
+	    ms = tp->tv_sec*1000 + (tp->tv_usec+999)/1000;
+    }
+    if (_ee_epfd == -1){ /* No fds registered yet, only timeouts */
+	if (select(0, NULL, NULL, NULL, tp) < 0)
+	    return -1;
+	return 0;
+    }
+    if ((n = epoll_wait(_ee_epfd, evs, EVENT_MAXFDS, ms)) < 0)
+	return -1;
+    for (i=0; i<n; i++)
+	fds[i] = evs[i].data.fd;
+    return n;
+#else /* HAVE_SYS_EPOLL_H */
+    struct event_data *e;
+    fd_set             fdset;
+    int                n;
+    int                i;
+    int                fd;
+
+    FD_ZERO(&fdset);
+    for (i=0; i<EVENT_FDHASH; i++)
+	for (e=ee[i]; e; e=e->e_next)
+	    FD_SET(e->e_fd, &fdset);
+    if ((n = select(FD_SETSIZE, &fdset, NULL, NULL, tp)) < 0)
+	return -1;
+    for (i=0, fd=0; fd<FD_SETSIZE && i<n && i<EVENT_MAXFDS; fd++)
+	if (FD_ISSET(fd, &fdset))
+	    fds[i++] = fd;
+    return i;
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+/*! Dispatch file descriptor events and timeouts by invoking callbacks.
+ * All timeouts that have expired are called in each loop (after the fd 
+ * callbacks) but not timeouts registered by the callbacks themselves.
  */
 int
 event_loop(void)
 {
     struct event_data *e, *e_next;
     int n;
+    int i;
+    int failed;
+    int fds[EVENT_MAXFDS];
     struct timeval t, t0, tnull={0,};
-    fd_set fdset;
     int retval = -1;
 
     while (!clicon_exit_get()){
-	FD_ZERO(&fdset);
-	for (e=ee; e; e=e->e_next)
-	    if (e->e_type == EVENT_FD)
-		FD_SET(e->e_fd, &fdset);
-	if (ee_timers != NULL){
+	if (ee_timers_len){
 	    gettimeofday(&t0, NULL);
-	    timersub(&ee_timers->e_time, &t0, &t); 
+	    timersub(&ee_timers[0]->e_time, &t0, &t); 
 	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
+		n = event_poll(&tnull, fds);
 	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+		n = event_poll(&t, fds);
 	}
 	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL); 
+	    n = event_poll(NULL, fds);
 	if (clicon_exit_get())
 	    break;
 	if (n == -1) {
@@ -292,33 +469,52 @@ event_loop(void)
 		clicon_err(OE_EVENTS, errno, "%s select2", __FUNCTION__);
 	    goto err;
 	}
-	if (n==0){ /* Timeout */
-	    e = ee_timers;
-	    ee_timers = ee_timers->e_next;
-	    clicon_debug(2, "%s timeout: %s[%x]", 
-		    __FUNCTION__, e->e_string, e->e_arg);
-	    if ((*e->e_fn)(0, e->e_arg) < 0){
-		free(e);
-		goto err;
-	    }
-	    free(e);
-	}
 	_ee_unreg = 0;
-	for (e=ee; e; e=e_next){
-	    if (clicon_exit_get())
-		break;
-	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
+	for (i=0; i<n && !_ee_unreg; i++){
+	    for (e=ee[fds[i] & (EVENT_FDHASH-1)]; e; e=e_next){
+		if (clicon_exit_get())
+		    break;
+		e_next = e->e_next;
+		if (e->e_fd != fds[i])
+		    continue;
 		clicon_debug(2, "%s: FD_ISSET: %s[%x]", 
-			__FUNCTION__, e->e_string, e->e_arg);
+			     __FUNCTION__, e->e_string, e->e_arg);
 		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0)
 		    goto err;
-		if (_ee_unreg){
-		    _ee_unreg = 0;
+		/* Registrations may have changed, poll again */
+		if (_ee_unreg)
 		    break;
-		}
 	    }
 	}
+	/* Collect expired timeouts, then call them. Callbacks may deregister 
+	   collected timeouts, see event_unreg_timeout */
+	if (ee_timers_len){
+	    gettimeofday(&t0, NULL);
+	    while (ee_timers_len && !timercmp(&ee_timers[0]->e_time, &t0, >)){
+		e = event_timer_rm(0);
+		e->e_next = ee_expired;
+		ee_expired = e;
+	    }
+	}
+	/* Reverse to call in time order */
+	for (e = ee_expired, ee_expired = NULL; e; e = e_next){
+	    e_next = e->e_next;
+	    e->e_next = ee_expired;
+	    ee_expired = e;
+	}
+	failed = 0;
+	while ((e = ee_expired) != NULL){
+	    ee_expired = e->e_next;
+	    if (!failed && !clicon_exit_get()){
+		clicon_debug(2, "%s timeout: %s[%x]", 
+			     __FUNCTION__, e->e_string, e->e_arg);
+		if ((*e->e_fn)(0, e->e_arg) < 0)
+		    failed++;
+	    }
+	    free(e);
+	}
+	if (failed)
+	    goto err;
 	continue;
       err:
 	break;
@@ -331,18 +527,28 @@ int
 event_exit(void)
 {
     struct event_data *e, *e_next;
+    int i;
     
-    e_next = ee;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
-    }
-    ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
+    for (i=0; i<EVENT_FDHASH; i++){
+	e_next = ee[i];
+	while ((e = e_next) != NULL){
+	    e_next = e->e_next;
+	    free(e);
+	}
+	ee[i] = NULL;
     }
+    for (i=0; i<ee_timers_len; i++)
+	free(ee_timers[i]);
+    if (ee_timers)
+	free(ee_timers);
     ee_timers = NULL;
+    ee_timers_len = 0;
+    ee_timers_size = 0;
+#ifdef HAVE_SYS_EPOLL_H
+    if (_ee_epfd != -1){
+	close(_ee_epfd);
+	_ee_epfd = -1;
+    }
+#endif
     return 0;
 }
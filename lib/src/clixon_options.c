@@ -615,6 +615,18 @@ clicon_xmldb_dir(clicon_handle h)
     return clicon_option_str(h, "CLICON_XMLDB_DIR");
 }
 
+/*! Keep datastores in memory in the xmldb plugin (0 or 1) */
+int
+clicon_xmldb_cache(clicon_handle h)
+{
+    char const *opt = "CLICON_XMLDB_CACHE";
+
+    if (clicon_option_exists(h, opt))
+	return clicon_option_int(h, opt);
+    else
+	return 0;
+}
+
 /*! Get YANG specification
  * Must use hash functions directly since they are not strings.
  */
@@ -758,3 +770,41 @@ clicon_xmldb_handle_get(clicon_handle h)
 	return *(void**)xh;
     return NULL;
 }
+
+/*! Set or reset persistent session socket to backend
+ * @param[in]  h   Clicon handle
+ * @param[in]  s   Open socket to backend. If -1 reset it
+ * @note Just keep note of it, the caller opens and closes the socket
+ * @see clicon_rpc_msg  where the session socket is used
+ */
+int
+clicon_client_socket_set(clicon_handle h, 
+			 int           s)
+{
+    clicon_hash_t  *cdat = clicon_data(h);
+
+    if (s == -1){
+	hash_del(cdat, "client-socket"); /* may not exist */
+	return 0;
+    }
+    if (hash_add(cdat, "client-socket", &s, sizeof(int)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Get persistent session socket to backend
+ * @param[in]  h   Clicon handle
+ * @retval     s   Open socket to backend
+ * @retval    -1   No session socket open
+ */
+int
+clicon_client_socket_get(clicon_handle h)
+{
+    clicon_hash_t  *cdat = clicon_data(h);
+    size_t          len;
+    void           *p;
+
+    if ((p = hash_value(cdat, "client-socket", &len)) != NULL)
+	return *(int*)p;
+    return -1;
+}
@@ -73,6 +73,14 @@
 
 static int _atomicio_sig = 0;
 
+/* Reply to version 1 client if reply does not fit in its message header */
+static char *msg_toobig = "<rpc-reply><rpc-error>"
+    "<error-tag>too-big</error-tag>"
+    "<error-type>application</error-type>"
+    "<error-severity>error</error-severity>"
+    "<error-message>Reply does not fit in version 1 message</error-message>"
+    "</rpc-error></rpc-reply>";
+
 /*! Formats (showas) derived from XML
  */
 struct formatvec{
@@ -146,7 +154,8 @@ clicon_msg_encode(char *format, ...)
     }
     memset(msg, 0, len);
     /* hdr */
-    msg->op_len = htons(len);
+    msg->op_version = htons(CLICON_MSG_VERSION);
+    msg->op_len = htonl(len);
 
     /* body */
     va_start(args, format);
@@ -213,6 +222,39 @@ clicon_connect_unix(char *sockpath)
     return retval;
 }
 
+/*! Open connection to backend using an IPv4 tcp socket
+ * @param[in]  dst     IPv4 address
+ * @param[in]  port    TCP port
+ * @retval     s       socket
+ * @retval     -1      error
+ */
+int
+clicon_connect_inet(char    *dst,
+		    uint16_t port)
+{
+    struct sockaddr_in addr;
+    int                s;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(addr.sin_family, dst, &addr.sin_addr) != 1){
+	clicon_err(OE_CFG, errno, "inet_pton: %s (Expected IPv4 address)", dst);
+	return -1; /* Could check getaddrinfo */
+    }
+    if ((s = socket(addr.sin_family, SOCK_STREAM, 0)) < 0) {
+	clicon_err(OE_CFG, errno, "socket");
+	return -1;
+    }
+    clicon_debug(2, "%s: connecting to %s:%hu", __FUNCTION__, dst, port);
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+	clicon_err(OE_CFG, errno, "connecting socket inet4");
+	close(s);
+	return -1;
+    }
+    return s;
+}
+
 static void
 atomicio_sig_handler(int arg)
 {
@@ -267,7 +309,7 @@ msg_dump(struct clicon_msg *msg)
     
     memset(buf2, 0, sizeof(buf2));
     snprintf(buf2, sizeof(buf2), "%s:", __FUNCTION__);
-    for (i=0; i<ntohs(msg->op_len); i++){
+    for (i=0; i<ntohl(msg->op_len); i++){
 	snprintf(buf, sizeof(buf), "%s%02x", buf2, ((char*)msg)[i]&0xff);
 	if ((i+1)%32==0){
 	    clicon_debug(2, buf);
@@ -291,17 +333,39 @@ int
 clicon_msg_send(int                s, 
 		struct clicon_msg *msg)
 { 
-    int retval = -1;
-
-    clicon_debug(2, "%s: send msg len=%d", 
-		 __FUNCTION__, ntohs(msg->op_len));
+    int      retval = -1;
+    uint32_t mlen;
+    uint16_t hdr1;    /* version 1 header: length */
+    char    *buf;
+    size_t   len;
+
+    mlen = ntohl(msg->op_len);
+    clicon_debug(2, "%s: send msg len=%u", 
+		 __FUNCTION__, mlen);
     if (debug > 2)
 	msg_dump(msg);
+    buf = (char*)msg;
+    len = mlen;
+    if (ntohs(msg->op_version) == 1){ /* Peer only understands version 1 */
+	if (mlen - sizeof(*msg) + sizeof(hdr1) > 0xffff){
+	    clicon_err(OE_PROTO, EMSGSIZE, "%s: message too long for version 1 header (%u)",
+		       __FUNCTION__, mlen);
+	    goto done;
+	}
+	hdr1 = htons(mlen - sizeof(*msg) + sizeof(hdr1));
+	if (atomicio((ssize_t (*)(int, void *, size_t))write, 
+		     s, &hdr1, sizeof(hdr1)) < 0){
+	    clicon_err(OE_CFG, errno, "%s", __FUNCTION__);
+	    goto done;
+	}
+	buf = msg->op_body;
+	len = mlen - sizeof(*msg);
+    }
     if (atomicio((ssize_t (*)(int, void *, size_t))write, 
-		 s, msg, ntohs(msg->op_len)) < 0){
+		 s, buf, len) < 0){
 	clicon_err(OE_CFG, errno, "%s", __FUNCTION__);
-	clicon_log(LOG_WARNING, "%s: write: %s len:%d msg:%s", __FUNCTION__,
-		   strerror(errno), ntohs(msg->op_len), msg->op_body);
+	clicon_log(LOG_WARNING, "%s: write: %s len:%u msg:%s", __FUNCTION__,
+		   strerror(errno), mlen, msg->op_body);
 	goto done;
     }
     retval = 0;
@@ -322,7 +386,8 @@ clicon_msg_send(int                s,
  *
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[out]  msg    CLICON msg data reply structure. Free with free()
- * @param[out]  eof    Set if eof encountered
+ * @param[out]  eof    Set if eof encountered, or the connection was reset,
+ *                     before the start of a message
  * Note: caller must ensure that s is closed if eof is set after call.
  */
 int
@@ -332,41 +397,77 @@ clicon_msg_rcv(int                s,
 { 
     int       retval = -1;
     struct clicon_msg hdr;
-    int       hlen;
-    int       len2;
+    uint16_t  hdr1;    /* version 1 header, or zero word of version 2 header */
+    ssize_t   hlen;
+    ssize_t   len2;
     sigfn_t   oldhandler;
-    uint16_t  mlen;
+    size_t    blen;    /* body length */
 
+    *msg = NULL;
     *eof = 0;
     if (0)
 	set_signal(SIGINT, atomicio_sig_handler, &oldhandler);
 
-    if ((hlen = atomicio(read, s, &hdr, sizeof(hdr))) < 0){ 
+    if ((hlen = atomicio(read, s, &hdr1, sizeof(hdr1))) < 0 && errno != ECONNRESET){ 
 	clicon_err(OE_CFG, errno, "%s", __FUNCTION__);
 	goto done;
     }
-    if (hlen == 0){
+    if (hlen <= 0){ /* Closed or reset by peer */
 	retval = 0;
 	*eof = 1;
 	goto done;
     }
-    if (hlen != sizeof(hdr)){
-	clicon_err(OE_CFG, errno, "%s: header too short (%d)", __FUNCTION__, hlen);
+    if (hlen != sizeof(hdr1)){
+	clicon_err(OE_CFG, errno, "%s: header too short (%zd)", __FUNCTION__, hlen);
 	goto done;
     }
-    mlen = ntohs(hdr.op_len);
-    clicon_debug(2, "%s: rcv msg len=%d",  
-		 __FUNCTION__, mlen);
-    if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
+    memset(&hdr, 0, sizeof(hdr));
+    if (hdr1 != 0){ /* Version 1 header: only length */
+	if (ntohs(hdr1) < sizeof(hdr1)){
+	    clicon_err(OE_PROTO, EBADMSG, "%s: bad length (%hu)", __FUNCTION__, ntohs(hdr1));
+	    goto done;
+	}
+	blen = ntohs(hdr1) - sizeof(hdr1);
+	hdr.op_version = htons(1);
+    }
+    else{
+	hlen = atomicio(read, s, (char*)&hdr + sizeof(hdr1), sizeof(hdr) - sizeof(hdr1));
+	if (hlen != sizeof(hdr) - sizeof(hdr1)){
+	    clicon_err(OE_CFG, errno, "%s: header too short", __FUNCTION__);
+	    goto done;
+	}
+	if (ntohs(hdr.op_version) != CLICON_MSG_VERSION){
+	    clicon_err(OE_PROTO, EPROTONOSUPPORT, "%s: unsupported version (%hu)",
+		       __FUNCTION__, ntohs(hdr.op_version));
+	    goto done;
+	}
+	if (ntohl(hdr.op_len) < sizeof(hdr)){
+	    clicon_err(OE_PROTO, EBADMSG, "%s: bad length (%u)", __FUNCTION__, ntohl(hdr.op_len));
+	    goto done;
+	}
+	if (ntohl(hdr.op_len) > CLICON_MSG_MAXLEN){
+	    clicon_err(OE_PROTO, EMSGSIZE, "%s: message too long (%u > %u)",
+		       __FUNCTION__, ntohl(hdr.op_len), CLICON_MSG_MAXLEN);
+	    goto done;
+	}
+	blen = ntohl(hdr.op_len) - sizeof(hdr);
+    }
+    hdr.op_len = htonl(sizeof(hdr) + blen);
+    clicon_debug(2, "%s: rcv msg version=%hu len=%u",  
+		 __FUNCTION__, ntohs(hdr.op_version), ntohl(hdr.op_len));
+    /* Extra byte ensures body is a string even if sender did not terminate it */
+    if ((*msg = (struct clicon_msg *)malloc(sizeof(hdr) + blen + 1)) == NULL){
 	clicon_err(OE_CFG, errno, "malloc");
 	goto done;
     }
-    memcpy(*msg, &hdr, hlen);
-    if ((len2 = read(s, (*msg)->op_body, mlen - sizeof(hdr))) < 0){
+    memcpy(*msg, &hdr, sizeof(hdr));
+    (*msg)->op_body[blen] = '\0';
+    /* Large messages arrive in several segments: loop until all is read */
+    if ((len2 = atomicio(read, s, (*msg)->op_body, blen)) < 0){
 	clicon_err(OE_CFG, errno, "%s: read", __FUNCTION__);
 	goto done;
     }
-    if (len2 != mlen - sizeof(hdr)){
+    if (len2 != blen){
 	clicon_err(OE_CFG, errno, "%s: body too short", __FUNCTION__);
 	goto done;
     }
@@ -374,6 +475,10 @@ clicon_msg_rcv(int                s,
 	msg_dump(*msg);
     retval = 0;
   done:
+    if (retval < 0 && *msg){
+	free(*msg);
+	*msg = NULL;
+    }
     if (0)
 	set_signal(SIGINT, oldhandler, NULL);
     return retval;
@@ -417,7 +522,7 @@ clicon_rpc_connect_unix(struct clicon_msg *msg,
 	*sock0 = s;
     retval = 0;
   done:
-    if (sock0 == NULL && s >= 0)
+    if ((sock0 == NULL || retval < 0) && s >= 0)
 	close(s);
     return retval;
 }
@@ -442,33 +547,17 @@ clicon_rpc_connect_inet(struct clicon_msg *msg,
 {
     int                retval = -1;
     int                s = -1;
-    struct sockaddr_in addr;
 
     clicon_debug(1, "Send msg to %s:%hu", dst, port);
-
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
-    if (inet_pton(addr.sin_family, dst, &addr.sin_addr) != 1)
-	goto done; /* Could check getaddrinfo */
-    
-    /* special error handling to get understandable messages (otherwise ENOENT) */
-    if ((s = socket(addr.sin_family, SOCK_STREAM, 0)) < 0) {
-	clicon_err(OE_CFG, errno, "socket");
-	return -1;
-    }
-    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0){
-	clicon_err(OE_CFG, errno, "connecting socket inet4");
-	close(s);
+    if ((s = clicon_connect_inet(dst, port)) < 0)
 	goto done;
-    }
     if (clicon_rpc(s, msg, retdata) < 0)
 	goto done;
     if (sock0 != NULL)
 	*sock0 = s;
     retval = 0;
   done:
-    if (sock0 == NULL && s >= 0)
+    if ((sock0 == NULL || retval < 0) && s >= 0)
 	close(s);
     return retval;
 }
@@ -479,6 +568,8 @@ clicon_rpc_connect_inet(struct clicon_msg *msg,
  * retval may be -1 and
  * errno set to ENOTCONN which means that socket is now closed probably
  * due to remote peer disconnecting. The caller may have to do something,...
+ * The socket is not closed on error, it is owned by the caller.
+ * The reply must carry the same request id as msg.
  *
  * @param[in]  s       Socket to communicate with backend
  * @param[in]  msg     CLICON msg data structure. It has fixed header and variable body.
@@ -503,10 +594,14 @@ clicon_rpc(int                   s,
 	goto done;
     if (eof){
 	clicon_err(OE_PROTO, ESHUTDOWN, "%s: Socket unexpected close", __FUNCTION__);
-	close(s);
 	errno = ESHUTDOWN;
 	goto done;
     }
+    if (reply->op_id != msg->op_id){
+	clicon_err(OE_PROTO, EPROTO, "%s: Reply id %hu does not match request id %hu",
+		   __FUNCTION__, ntohs(reply->op_id), ntohs(msg->op_id));
+	goto done;
+    }
     data = reply->op_body; /* assume string */
     if (ret && data)
 	if ((*ret = strdup(data)) == NULL){
@@ -525,25 +620,36 @@ clicon_rpc(int                   s,
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
  * @param[in]  s       Socket to communicate with client
+ * @param[in]  req     Request message. Reply has its id and header version
  * @param[in]  data    Returned data as byte-string.
  * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
  * @retval     0       OK
  * @retval     -1      Error
  */
 int 
-send_msg_reply(int      s, 
-	       char    *data, 
-	       uint16_t datalen)
+send_msg_reply(int                s, 
+	       struct clicon_msg *req,
+	       char              *data, 
+	       uint32_t           datalen)
 {
     int                retval = -1;
     struct clicon_msg *reply = NULL;
-    uint16_t           len;
+    uint32_t           len;
 
+    if (ntohs(req->op_version) == 1 && 
+	sizeof(uint16_t) + datalen > 0xffff){
+	data = msg_toobig;
+	datalen = strlen(msg_toobig) + 1;
+    }
     len = sizeof(*reply) + datalen;
-    if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
+    if ((reply = (struct clicon_msg *)malloc(len)) == NULL){
+	clicon_err(OE_PROTO, errno, "malloc");
 	goto done;
+    }
     memset(reply, 0, len);
-    reply->op_len = htons(len);
+    reply->op_version = req->op_version;
+    reply->op_len = htonl(len);
+    reply->op_id = req->op_id;
     if (datalen > 0)
       memcpy(reply->op_body, data, datalen);
     if (clicon_msg_send(s, reply) < 0)
@@ -555,24 +661,100 @@ send_msg_reply(int      s,
     return retval;
 }
 
+/*! Send an xml tree as reply to a clicon rpc request, streamed to the socket
+ *
+ * As send_msg_reply, but the reply body is: <pre><xt><post>. The tree is
+ * serialized directly to the socket in chunks, so that neither the body
+ * nor the message is built in memory. The length in the message header is
+ * computed by a first counting pass.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  req     Request message. Reply has its id and header version
+ * @param[in]  pre     String before xml tree, eg "<rpc-reply>"
+ * @param[in]  xt      XML tree
+ * @param[in]  post    String after xml tree, eg "</rpc-reply>"
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see clicon_xml2stream
+ */
+int 
+send_msg_reply_xml(int                s, 
+		   struct clicon_msg *req,
+		   char              *pre,
+		   cxobj             *xt,
+		   char              *post)
+{
+    int                retval = -1;
+    xml_stream        *xs = NULL;
+    struct clicon_msg  hdr;
+    uint16_t           hdr1; /* version 1 header: length */
+    size_t             datalen;
+
+    /* First pass: count body length incl terminating null */
+    if ((xs = xml_stream_new(-1)) == NULL)
+	goto done;
+    if (xml_stream_str(xs, pre, strlen(pre)) < 0 ||
+	clicon_xml2stream(xs, xt, 0, 0) < 0 ||
+	xml_stream_str(xs, post, strlen(post)+1) < 0)
+	goto done;
+    datalen = xml_stream_len(xs);
+    xml_stream_free(xs);
+    xs = NULL;
+    if (ntohs(req->op_version) == 1 && 
+	sizeof(hdr1) + datalen > 0xffff){
+	retval = send_msg_reply(s, req, msg_toobig, strlen(msg_toobig) + 1);
+	goto done;
+    }
+    clicon_debug(2, "%s: send msg len=%zu", __FUNCTION__, sizeof(hdr) + datalen);
+    /* Second pass: write header and body */
+    if ((xs = xml_stream_new(s)) == NULL)
+	goto done;
+    if (ntohs(req->op_version) == 1){
+	hdr1 = htons(sizeof(hdr1) + datalen);
+	if (xml_stream_str(xs, (char*)&hdr1, sizeof(hdr1)) < 0)
+	    goto done;
+    }
+    else{
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.op_version = req->op_version;
+	hdr.op_len = htonl(sizeof(hdr) + datalen);
+	hdr.op_id = req->op_id;
+	if (xml_stream_str(xs, (char*)&hdr, sizeof(hdr)) < 0)
+	    goto done;
+    }
+    if (xml_stream_str(xs, pre, strlen(pre)) < 0 ||
+	clicon_xml2stream(xs, xt, 0, 0) < 0 ||
+	xml_stream_str(xs, post, strlen(post)+1) < 0)
+	goto done;
+    if (xml_stream_flush(xs) < 0)
+	goto done;
+    retval = 0;
+  done:
+    if (xs)
+	xml_stream_free(xs);
+    return retval;
+}
+
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
  * @param[in]  s       Socket to communicate with client
+ * @param[in]  version Header version understood by client, see CLICON_MSG_VERSION
  * @param[in]  level
  * @param[in]  event
  * @retval     0       OK
  * @retval     -1      Error
  */
 int
-send_msg_notify(int   s, 
-		int   level, 
-		char *event)
+send_msg_notify(int      s, 
+		uint16_t version,
+		int      level, 
+		char    *event)
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
 
     if ((msg=clicon_msg_encode("<notification><event>%s</event></notification>", event)) == NULL)
 	goto done;
+    msg->op_version = htons(version);
     if (clicon_msg_send(s, msg) < 0)
 	goto done;
     retval = 0;
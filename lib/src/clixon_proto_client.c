@@ -49,6 +49,8 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <signal.h>
 #include <sys/syslog.h>
 
 /* cligen */
@@ -66,15 +68,281 @@
 #include "clixon_xsl.h"
 #include "clixon_proto.h"
 #include "clixon_err.h"
+#include "clixon_sig.h"
 #include "clixon_proto_client.h"
 
+/*! Get the persistent session socket of a handle, connect to backend if not open
+ * @param[in]  h      CLICON handle
+ * @retval     s      Open session socket to backend
+ * @retval     -1     Error
+ * @see clicon_rpc_session_close
+ */
+static int
+clicon_rpc_session(clicon_handle h)
+{
+    int         s;
+    char       *sock;
+    int         port;
+    struct stat sb;
+
+    if ((s = clicon_client_socket_get(h)) != -1)
+	return s;
+    if ((sock = clicon_sock(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "CLICON_SOCK option not set");
+	return -1;
+    }
+    switch (clicon_sock_family(h)){
+    case AF_UNIX:
+	/* special error handling to get understandable messages (otherwise ENOENT) */
+	if (stat(sock, &sb) < 0){
+	    clicon_err(OE_PROTO, errno, "%s: config daemon not running?", sock);
+	    return -1;
+	}
+	if (!S_ISSOCK(sb.st_mode)){
+	    clicon_err(OE_PROTO, EIO, "%s: Not unix socket", sock);
+	    return -1;
+	}
+	if ((s = clicon_connect_unix(sock)) < 0)
+	    return -1;
+	break;
+    case AF_INET:
+	if ((port = clicon_sock_port(h)) < 0){
+	    clicon_err(OE_FATAL, 0, "CLICON_SOCK_PORT not set");
+	    return -1;
+	}
+	if ((s = clicon_connect_inet(sock, port)) < 0)
+	    return -1;
+	break;
+    default:
+	clicon_err(OE_FATAL, 0, "Unknown CLICON_SOCK_FAMILY");
+	return -1;
+    }
+    if (clicon_client_socket_set(h, s) < 0){
+	close(s);
+	return -1;
+    }
+    clicon_debug(1, "%s: session socket %d opened", __FUNCTION__, s);
+    return s;
+}
+
+/*! Get number of requests sent on the session socket not yet replied to
+ * @param[in]  h      CLICON handle
+ * @see clicon_rpc_outstanding_add
+ */
+static int
+clicon_rpc_outstanding(clicon_handle h)
+{
+    int *p;
+
+    if ((p = hash_value(clicon_data(h), "client-outstanding", NULL)) == NULL)
+	return 0;
+    return *p;
+}
+
+/*! Add to number of requests sent on the session socket not yet replied to
+ * @param[in]  h      CLICON handle
+ * @param[in]  n      Nr to add, 1 when sent and -1 when reply is received
+ */
+static int
+clicon_rpc_outstanding_add(clicon_handle h,
+			   int           n)
+{
+    int nr;
+
+    nr = clicon_rpc_outstanding(h) + n;
+    if (hash_add(clicon_data(h), "client-outstanding", &nr, sizeof(nr)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Close the persistent session socket of a handle, if open
+ * Replies to outstanding requests are lost, and replies saved in the handle
+ * but not yet asked for are removed. Next rpc will reconnect.
+ * @param[in]  h      CLICON handle
+ */
+int
+clicon_rpc_session_close(clicon_handle h)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    int            s;
+    char         **keys;
+    size_t         nkeys;
+    int            i;
+
+    if ((s = clicon_client_socket_get(h)) != -1){
+	clicon_debug(1, "%s: session socket %d closed", __FUNCTION__, s);
+	close(s);
+	clicon_client_socket_set(h, -1);
+    }
+    if ((keys = hash_keys(cdat, &nkeys)) != NULL){
+	for (i=0; i<nkeys; i++)
+	    if (strncmp(keys[i], "client-reply-", strlen("client-reply-")) == 0)
+		hash_del(cdat, keys[i]);
+	free(keys);
+    }
+    hash_del(cdat, "client-outstanding");
+    return 0;
+}
+
+/*! Send a message on the session socket without waiting for the reply
+ * Several requests may be outstanding (pipelined) on the session socket.
+ * Use clicon_rpc_msg_recv() with the returned id to get the reply.
+ * @param[in]    h      CLICON handle
+ * @param[in]    msg    Encoded message. Its request id is set here.
+ * @param[out]   id     Request id of the message, to match the reply
+ * @retval       0      OK
+ * @retval      -1      Error, errno is set and session socket is closed
+ */
+int
+clicon_rpc_msg_send(clicon_handle      h, 
+		    struct clicon_msg *msg, 
+		    uint16_t          *id)
+{
+    int                retval = -1;
+    clicon_hash_t     *cdat = clicon_data(h);
+    uint16_t           reqid = 0;
+    void              *p;
+    size_t             len;
+    int                s;
+    sigfn_t            oldhandler;
+
+    if ((s = clicon_rpc_session(h)) < 0)
+	goto done;
+    if ((p = hash_value(cdat, "client-reqid", &len)) != NULL)
+	reqid = *(uint16_t*)p;
+    if (++reqid == 0) /* id 0 is reserved for unsolicited messages, eg notifications */
+	reqid++;
+    if (hash_add(cdat, "client-reqid", &reqid, sizeof(reqid)) == NULL)
+	goto done;
+    msg->op_id = htons(reqid);
+    /* Backend may have closed the socket, get EPIPE instead of a signal */
+    if (set_signal(SIGPIPE, SIG_IGN, &oldhandler) < 0)
+	goto done;
+    if (clicon_msg_send(s, msg) < 0){
+	set_signal(SIGPIPE, oldhandler, NULL);
+	clicon_rpc_session_close(h);
+	errno = clicon_suberrno;
+	goto done;
+    }
+    set_signal(SIGPIPE, oldhandler, NULL);
+    if (clicon_rpc_outstanding_add(h, 1) < 0)
+	goto done;
+    *id = reqid;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Receive the reply of a request sent with clicon_rpc_msg_send
+ * Replies of other outstanding requests read on the way are saved in the
+ * handle until asked for. A reply without request id (id 0), eg from a 
+ * version 1 backend, is the reply of the request if it is the only 
+ * outstanding request, and an error otherwise.
+ * @param[in]    h      CLICON handle
+ * @param[in]    id     Request id as returned by clicon_rpc_msg_send
+ * @param[out]   xret0  Return value from backend as netconf xml tree. Free w xml_free
+ * @retval       0      OK
+ * @retval      -1      Error, errno is set and session socket is closed. errno
+ *                      is ESHUTDOWN if the backend closed or reset the session
+ *                      before the start of a reply.
+ */
+int
+clicon_rpc_msg_recv(clicon_handle h, 
+		    uint16_t      id,
+		    cxobj       **xret0)
+{
+    int                retval = -1;
+    clicon_hash_t     *cdat = clicon_data(h);
+    struct clicon_msg *reply = NULL;
+    char               key[32];
+    char              *retdata = NULL;
+    cxobj             *xret = NULL;
+    int                s;
+    int                eof;
+    size_t             len;
+    uint16_t           rid;
+
+    snprintf(key, sizeof(key), "client-reply-%hu", id);
+    if ((retdata = hash_value(cdat, key, &len)) != NULL){
+	if ((retdata = strdup(retdata)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	hash_del(cdat, key);
+    }
+    while (retdata == NULL){
+	if ((s = clicon_client_socket_get(h)) == -1){
+	    clicon_err(OE_PROTO, ENOTCONN, "%s: No session to backend", __FUNCTION__);
+	    errno = ENOTCONN;
+	    goto done;
+	}
+	if (clicon_msg_rcv(s, &reply, &eof) < 0){
+	    clicon_rpc_session_close(h);
+	    errno = clicon_suberrno;
+	    goto done;
+	}
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "%s: Socket unexpected close", __FUNCTION__);
+	    clicon_rpc_session_close(h);
+	    errno = ESHUTDOWN;
+	    goto done;
+	}
+	rid = ntohs(reply->op_id);
+	if (rid == 0 && clicon_rpc_outstanding(h) != 1){
+	    clicon_err(OE_PROTO, EBADMSG, "%s: Reply without request id with %d outstanding requests",
+		       __FUNCTION__, clicon_rpc_outstanding(h));
+	    clicon_rpc_session_close(h);
+	    errno = EBADMSG;
+	    goto done;
+	}
+	if (clicon_rpc_outstanding_add(h, -1) < 0)
+	    goto done;
+	if (rid == id || rid == 0){
+	    if ((retdata = strdup(reply->op_body)) == NULL){
+		clicon_err(OE_UNIX, errno, "strdup");
+		goto done;
+	    }
+	}
+	else { /* Reply to another pipelined request: save it */
+	    snprintf(key, sizeof(key), "client-reply-%hu", rid);
+	    if (hash_add(cdat, key, reply->op_body, strlen(reply->op_body)+1) == NULL)
+		goto done;
+	}
+	free(reply);
+	reply = NULL;
+    }
+    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
+    if (clicon_xml_parse_str(retdata, &xret) < 0)
+	goto done;
+    if (xret0){
+	*xret0 = xret;
+	xret = NULL;
+    }
+    retval = 0;
+ done:
+    if (reply)
+	free(reply);
+    if (retdata)
+	free(retdata);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend
+ * Unless sock0 is given, the rpc is sent on the persistent session socket of
+ * the handle. The session is (re)connected if needed: if the backend has
+ * closed a reused session so that the rpc could not be sent, or closed or 
+ * reset it before any reply when the rpc was the only outstanding request, 
+ * the rpc is sent once more on a new session. Other errors after the rpc is
+ * sent are returned, since the backend may already have executed it.
  * @param[in]    h      CLICON handle
  * @param[in]    msg    Encoded message. Deallocate woth free
  * @param[out]   xret   Return value from backend as netconf xml tree. Free w xml_free
  * @param[inout] sock0  If pointer exists, do not close socket to backend on success 
  *                      and return it here. For keeping a notify socket open
  * Note: sock0 is if connection should be persistent, like a notification/subscribe api
+ * @see clicon_rpc_msg_send  For pipelining several requests
  */
 int
 clicon_rpc_msg(clicon_handle      h, 
@@ -87,7 +355,33 @@ clicon_rpc_msg(clicon_handle      h,
     int                port;
     char              *retdata = NULL;
     cxobj             *xret = NULL;
+    uint16_t           id;
+    int                reuse;
+    int                single;
+    int                retry = 0;
 
+    if (sock0 == NULL){
+	while (1){
+	    reuse = clicon_client_socket_get(h) != -1;
+	    single = 0;
+	    if (clicon_rpc_msg_send(h, msg, &id) == 0){
+		single = clicon_rpc_outstanding(h) == 1;
+		if (clicon_rpc_msg_recv(h, id, xret0) == 0)
+		    break;
+		/* Only resend if not executed: closed before any reply */
+		if (!single || errno != ESHUTDOWN)
+		    goto done;
+	    }
+	    /* Only resend if an old session was closed by backend */
+	    else if (errno != EPIPE)
+		goto done;
+	    if (!reuse || retry++)
+		goto done;
+	    clicon_debug(1, "%s: session lost, reconnecting", __FUNCTION__);
+	}
+	retval = 0;
+	goto done;
+    }
     if ((sock = clicon_sock(h)) == NULL){
 	clicon_err(OE_FATAL, 0, "CLICON_SOCK option not set");
 	goto done;
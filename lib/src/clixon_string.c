@@ -51,9 +51,13 @@
 
 /* clicon */
 #include "clixon_queue.h"
+#include "clixon_hash.h"
 #include "clixon_string.h"
 #include "clixon_err.h"
 
+/* Table of interned strings, see clicon_intern */
+static clicon_hash_t *intern_hash = NULL;
+
 
 /*! Split string into a vector based on character delimiters. Using malloc
  *
@@ -404,6 +408,48 @@ clicon_strndup (const char *str,
  gcc -g -o clixon_string -I. -I../clixon ./clixon_string.c -lclixon -lcligen
  * Example run:
 */
+/*! Return a shared copy of a string, add it to the table of interned strings
+ * Equal interned strings have the same pointer, so they can be compared with
+ * ==. Interned strings are never freed and must not be modified. 
+ * Intern only strings from a bounded set, eg yang identifiers.
+ * @param[in]  str   String
+ * @retval     istr  Interned string equal to str
+ * @retval     NULL  Error
+ * @see clicon_intern_find
+ */
+char *
+clicon_intern(char *str)
+{
+    clicon_hash_t h;
+
+    if (intern_hash == NULL &&
+	(intern_hash = hash_init()) == NULL)
+	return NULL;
+    if ((h = hash_lookup(intern_hash, str)) == NULL &&
+	(h = hash_add(intern_hash, str, NULL, 0)) == NULL)
+	return NULL;
+    return h->h_key;
+}
+
+/*! Return the interned copy of a string, if it is interned
+ * Does not add str to the table of interned strings.
+ * @param[in]  str   String
+ * @retval     istr  Interned string equal to str
+ * @retval     NULL  str is not interned
+ * @see clicon_intern
+ */
+char *
+clicon_intern_find(char *str)
+{
+    clicon_hash_t h;
+
+    if (intern_hash == NULL || str == NULL)
+	return NULL;
+    if ((h = hash_lookup(intern_hash, str)) == NULL)
+	return NULL;
+    return h->h_key;
+}
+
 #if 0 /* Test program */
 
 static int
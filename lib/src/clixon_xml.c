@@ -43,6 +43,12 @@
 #include <fnmatch.h>
 #include <stdint.h>
 #include <assert.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -52,6 +58,7 @@
 #include "clixon_log.h"
 #include "clixon_string.h"
 #include "clixon_queue.h"
+#include "clixon_hash.h"
 #include "clixon_xml.h"
 #include "clixon_xml_parse.h"
 
@@ -59,11 +66,46 @@
  * Constants
  */
 #define BUFLEN 1024  /* Size of xml read buffer */
+#define XML_READ_BLOCK   65536 /* Read block size for sockets */
+#define XML_MMAP_MIN     65536 /* Regular files larger than this are mmap:ed */
+#define XML_STREAM_IOV   64    /* Max nr of pending segments in xml stream */
+#define XML_STREAM_CHUNK 65536 /* Flush xml stream when this many bytes pending */
+#define XML_CHILDVEC_MIN 4     /* Initial allocated length of child vector */
+#define CXVEC_MIN        4     /* Min allocated length of xml vector */
+#define XML_ARENA_BLOCK  32768 /* Size of arena memory blocks */
+#define XML_ARENA_HDR    16    /* Block header: next block pointer (aligned) */
+#define XML_HASH_OFFSET  0xcbf29ce484222325ULL /* FNV-1a 64-bit offset basis */
+#define XML_HASH_PRIME   0x100000001b3ULL      /* FNV-1a 64-bit prime */
+#define XML_KEYINDEX_MIN 8     /* Search parents with fewer children linearly */
+
+/* Internal node flags (x_iflags), not visible with xml_flag() */
+#define XML_ARENA_NAME   0x01  /* Name is allocated in arena */
+#define XML_ARENA_VALUE  0x02  /* Value is allocated in arena */
+#define XML_INTERN_NAME  0x04  /* Name is interned, see clicon_intern */
+#define XML_DESC_NODE    0x08  /* Node is (or was) in a tree with a descendant
+				  name index, see xml_desc_drop */
+#define XML_KEYINDEXED   0x10  /* Node is in a key index of its parent */
 
 /*
  * Types
  */
 
+/*! Memory arena of xml nodes, see xml_new_arena
+ * Nodes (and their name and value strings) are allocated from large blocks
+ * while the arena is open. They are not freed individually; all blocks are
+ * freed when the last node allocated in the arena is freed.
+ */
+struct xml_arena{
+    char             *xa_blocks;  /* List of blocks, linked via first word */
+    char             *xa_next;    /* Next free byte in current block */
+    size_t            xa_left;    /* Nr of free bytes in current block */
+    int               xa_refs;    /* Nr of nodes in arena not yet freed */
+    int               xa_open;    /* New nodes in tree are allocated in arena */
+    char             *xa_grow;    /* Last value grown, see xml_arena_grow */
+    size_t            xa_growcap; /* Allocated size of xa_grow */
+    size_t            xa_growlen; /* String length of xa_grow */
+};
+
 /*! xml tree node, with name, type, parent, children, etc 
  * Note that this is a private type not visible from externally, use
  * access functions.
@@ -74,6 +116,7 @@ struct xml{
     struct xml       *x_up;         /* parent node in hierarchy if any */
     struct xml      **x_childvec;   /* vector of children nodes */
     int               x_childvec_len; /* length of vector */
+    int               x_childvec_max; /* allocated length of vector */
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
     char             *x_value;      /* attribute and body nodes have values */
     int              _x_vector_i;   /* internal use: xml_child_each */
@@ -81,8 +124,61 @@ struct xml{
     void             *x_spec;       /* Pointer to specification, eg yang, by 
 				       reference, dont free */
     cg_var           *x_cv;           /* If body this contains the typed value */
+    struct xml_keyindex *x_index;   /* Key indexes of children, one per list
+				       or leaf-list name, see xml_find_keyindex */
+    clicon_hash_t    *x_desc;       /* Descendant name index, only in root.
+				       Removed when the tree changes */
+    struct xml_arena *x_arena;      /* Arena node is allocated in, or NULL */
+    int               x_iflags;     /* Internal flags, see XML_ARENA_NAME */
+    uint64_t          x_hash;       /* Content hash of subtree, 0 if not computed.
+				       Reset in node and ancestors on change */
+};
+
+/*! Streaming xml output, see clicon_xml2stream
+ * Segments point directly into the xml tree (or to constant strings) and are
+ * written with writev when enough is pending. No copy of the output is made.
+ */
+struct xml_stream{
+    int           xs_fd;      /* File descriptor to write to, -1: only count */
+    size_t        xs_len;     /* Total nr of bytes streamed */
+    size_t        xs_pending; /* Nr of bytes in xs_iov not yet written */
+    int           xs_iovlen;  /* Nr of segments in xs_iov */
+    struct iovec  xs_iov[XML_STREAM_IOV]; /* Pending segments */
+};
+
+/*! Key index of the children of an xml node with one name
+ * Open-addressed hash table (linear probing) of the children with the name of
+ * a yang list or leaf-list, hashed on the values of the key leafs (list) or
+ * on the body (leaf-list). Children are added and removed as they are added
+ * to and removed from the parent, or when their key values are set. The index
+ * is removed if a key value of an indexed child changes, and is then rebuilt
+ * at next lookup.
+ * Only one of several children with equal keys (an invalid tree) is indexed. 
+ */
+struct xml_keyindex{
+    struct xml_keyindex *xk_next;  /* Index of other name of same parent */
+    char                *xk_name;  /* Name of indexed children, allocated 
+				      with the index */
+    cvec                *xk_keys;  /* Key names of list, from yang, or NULL
+				      for leaf-list */
+    uint32_t             xk_size;  /* Nr of slots, power of 2 */
+    uint32_t             xk_len;   /* Nr of indexed children */
+    int                  xk_dups;  /* Some children with equal keys not indexed */
+    cxobj              **xk_slot;  /* Indexed children */
 };
 
+/*! Descendant elements with one name, value in descendant name index */
+struct xml_descvec{
+    cxobj           **xd_vec;  /* Elements in document order */
+    size_t            xd_len;
+};
+
+static void xml_index_drop(cxobj *x);
+static void xml_index_link(cxobj *xp, cxobj *xc);
+static void xml_index_unlink(cxobj *xp, cxobj *xc);
+static void xml_desc_drop(cxobj *x);
+static void xml_hash_drop(cxobj *x);
+
 /* Mapping between xml type <--> string */
 static const map_str2int xsmap[] = {
     {"error",         CX_ERROR}, 
@@ -102,6 +198,147 @@ xml_type2str(enum cxobj_type type)
     return (char*)clicon_int2str(xsmap, type);
 }
 
+/*! Allocate memory from an xml arena
+ * @param[in]  xa   XML arena
+ * @param[in]  len  Nr of bytes
+ * @retval     p    Allocated memory, 8-byte aligned, not cleared
+ * @retval     NULL Error, clicon_err called
+ */
+static void *
+xml_arena_alloc(struct xml_arena *xa,
+		size_t            len)
+{
+    char *blk;
+    char *p;
+
+    len = (len + 7) & ~7;
+    if (len > XML_ARENA_BLOCK/4){ /* Large: own block, keep current block */
+	if ((blk = malloc(XML_ARENA_HDR + len)) == NULL){
+	    clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	    return NULL;
+	}
+	if (xa->xa_blocks){
+	    *(char**)blk = *(char**)xa->xa_blocks;
+	    *(char**)xa->xa_blocks = blk;
+	}
+	else{
+	    *(char**)blk = NULL;
+	    xa->xa_blocks = blk;
+	}
+	return blk + XML_ARENA_HDR;
+    }
+    if (len > xa->xa_left){
+	if ((blk = malloc(XML_ARENA_BLOCK)) == NULL){
+	    clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	    return NULL;
+	}
+	*(char**)blk = xa->xa_blocks;
+	xa->xa_blocks = blk;
+	xa->xa_next = blk + XML_ARENA_HDR;
+	xa->xa_left = XML_ARENA_BLOCK - XML_ARENA_HDR;
+    }
+    p = xa->xa_next;
+    xa->xa_next += len;
+    xa->xa_left -= len;
+    return p;
+}
+
+/*! Free all memory blocks of an xml arena and the arena itself
+ */
+static void
+xml_arena_free(struct xml_arena *xa)
+{
+    char *blk;
+
+    while ((blk = xa->xa_blocks) != NULL){
+	xa->xa_blocks = *(char**)blk;
+	free(blk);
+    }
+    free(xa);
+}
+
+/*! Make room for a value of a node in its open arena
+ * Used when appending to a value, eg character by character while parsing.
+ * The value last grown is extended in place if it ends the current block,
+ * which is the case while a body is parsed. Otherwise it is moved to a new 
+ * allocation of twice the size, so that appending is amortized linear in 
+ * both time and arena memory.
+ * @param[in]  xn    XML node, its arena is open
+ * @param[in]  len   Nr of bytes needed, including the terminating null
+ * @retval     0     OK, value has room for len bytes and is in the arena
+ * @retval    -1     Error, clicon_err called
+ */
+static int
+xml_arena_grow(cxobj  *xn,
+	       size_t  len)
+{
+    struct xml_arena *xa = xn->x_arena;
+    char             *old = xn->x_value;
+    size_t            cap;
+    char             *p;
+
+    len = (len + 7) & ~7;
+    cap = len;
+    if (old && old == xa->xa_grow){
+	if (len <= xa->xa_growcap)
+	    return 0;
+	if (old + xa->xa_growcap == xa->xa_next && 
+	    len - xa->xa_growcap <= xa->xa_left){ /* Extend in place */
+	    xa->xa_next += len - xa->xa_growcap;
+	    xa->xa_left -= len - xa->xa_growcap;
+	    xa->xa_growcap = len;
+	    return 0;
+	}
+	cap = 2*len;
+    }
+    if ((p = xml_arena_alloc(xa, cap)) == NULL)
+	return -1;
+    if (old){
+	strcpy(p, old);
+	if ((xn->x_iflags & XML_ARENA_VALUE) == 0)
+	    free(old);
+    }
+    else
+	p[0] = '\0';
+    xn->x_value = p;
+    xn->x_iflags |= XML_ARENA_VALUE;
+    xa->xa_grow = p;
+    xa->xa_growcap = cap;
+    return 0;
+}
+
+/*! Copy a name or value string of a node, in its arena if open
+ * @param[in]  xn    XML node
+ * @param[in]  str   String to copy
+ * @param[in]  len   Nr of bytes to allocate, at least strlen(str)+1
+ * @param[in]  flag  XML_ARENA_NAME or XML_ARENA_VALUE, set if copy in arena
+ * @retval     copy  Copied string
+ * @retval     NULL  Error, clicon_err called
+ */
+static char *
+xml_strdup(cxobj  *xn,
+	   char   *str,
+	   size_t  len,
+	   int     flag)
+{
+    char *copy;
+
+    if (xn->x_arena && xn->x_arena->xa_open){
+	if ((copy = xml_arena_alloc(xn->x_arena, len)) == NULL)
+	    return NULL;
+	xn->x_iflags |= flag;
+    }
+    else{
+	if ((copy = malloc(len)) == NULL){
+	    clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	    return NULL;
+	}
+	xn->x_iflags &= ~flag;
+    }
+    strcpy(copy, str);
+    return copy;
+}
+
 /*
  * Access functions
  */
@@ -115,6 +352,30 @@ xml_name(cxobj *xn)
     return xn->x_name;
 }
 
+/*! Check if name of xml node is equal to a name
+ * If both names are interned, only pointers are compared.
+ * @param[in]  xn     xml node
+ * @param[in]  name   Name
+ * @param[in]  iname  Interned name, ie clicon_intern_find(name), or NULL
+ * @retval     1      Equal
+ * @retval     0      Not equal
+ * @code
+ *   iname = clicon_intern_find(name);
+ *   while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+ *      if (xml_name_eq(x, name, iname))
+ *         ...
+ * @endcode
+ */
+int
+xml_name_eq(cxobj *xn,
+	    char  *name,
+	    char  *iname)
+{
+    if (iname && (xn->x_iflags & XML_INTERN_NAME))
+	return xn->x_name == iname;
+    return xn->x_name == name || strcmp(xn->x_name, name) == 0;
+}
+
 /*! Set name of xnode, name is copied
  * @param[in]  xn    xml node
  * @param[in]  name  new name, null-terminated string, copied by function
@@ -125,16 +386,26 @@ int
 xml_name_set(cxobj *xn, 
 	     char  *name)
 {
+    xml_index_unlink(xn->x_up, xn);
+    xml_desc_drop(xn->x_up);
+    xml_hash_drop(xn);
     if (xn->x_name){
-	free(xn->x_name);
+	if ((xn->x_iflags & (XML_ARENA_NAME|XML_INTERN_NAME)) == 0)
+	    free(xn->x_name);
 	xn->x_name = NULL;
     }
+    xn->x_iflags &= ~XML_INTERN_NAME;
     if (name){
-	if ((xn->x_name = strdup(name)) == NULL){
-	    clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
-	    return -1;
+	/* Names of yang schema nodes are interned, share them */
+	if ((xn->x_name = clicon_intern_find(name)) != NULL){
+	    xn->x_iflags &= ~XML_ARENA_NAME;
+	    xn->x_iflags |= XML_INTERN_NAME;
 	}
+	else if ((xn->x_name = xml_strdup(xn, name, strlen(name)+1, 
+					  XML_ARENA_NAME)) == NULL)
+	    return -1;
     }
+    xml_index_link(xn->x_up, xn);
     return 0;
 }
 
@@ -190,6 +461,8 @@ int
 xml_parent_set(cxobj *xn, 
 	       cxobj *parent)
 {
+    if (parent && xn->x_desc) /* No longer root */
+	xml_desc_drop(xn);
     xn->x_up = parent;
     return 0;
 }
@@ -249,16 +522,18 @@ int
 xml_value_set(cxobj *xn, 
 	      char  *val)
 {
+    xml_hash_drop(xn);
     if (xn->x_value){
-	free(xn->x_value);
+	if ((xn->x_iflags & XML_ARENA_VALUE) == 0)
+	    free(xn->x_value);
 	xn->x_value = NULL;
     }
     if (val){
-	if ((xn->x_value = strdup(val)) == NULL){
-	    clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
+	if ((xn->x_value = xml_strdup(xn, val, strlen(val)+1, 
+				      XML_ARENA_VALUE)) == NULL)
 	    return -1;
-	}
     }
+    xml_index_link(xn->x_up, xn);
     return 0;
 }
 
@@ -272,17 +547,36 @@ char *
 xml_value_append(cxobj *xn, 
 		 char  *val)
 {
-    int len0;
-    int len;
+    int   len0;
+    int   len;
+    char *old;
     
-    len0 = xn->x_value?strlen(xn->x_value):0;
+    xml_hash_drop(xn);
+    if (xn->x_value && xn->x_arena && xn->x_value == xn->x_arena->xa_grow)
+	len0 = xn->x_arena->xa_growlen; /* No strlen of a growing value */
+    else
+	len0 = xn->x_value?strlen(xn->x_value):0;
     if (val){
 	len = len0 + strlen(val);
-	if ((xn->x_value = realloc(xn->x_value, len+1)) == NULL){
+	if (xn->x_arena && xn->x_arena->xa_open){
+	    if (xml_arena_grow(xn, len+1) < 0)
+		return NULL;
+	    xn->x_arena->xa_growlen = len;
+	}
+	else if (xn->x_iflags & XML_ARENA_VALUE){ /* Closed arena: malloc */
+	    old = xn->x_value;
+	    if ((xn->x_value = xml_strdup(xn, old, len+1, 
+					  XML_ARENA_VALUE)) == NULL){
+		xn->x_value = old;
+		return NULL;
+	    }
+	}
+	else if ((xn->x_value = realloc(xn->x_value, len+1)) == NULL){
 	    clicon_err(OE_XML, errno, "realloc");
 	    return NULL;
 	}
 	strncpy(xn->x_value + len0, val, len-len0+1);
+	xml_index_link(xn->x_up, xn);
     }
     return xn->x_value;
 }
@@ -308,7 +602,14 @@ xml_type_set(cxobj          *xn,
 {
     enum cxobj_type old = xn->x_type;
 
+    if (old != type){
+	xml_index_unlink(xn->x_up, xn);
+	xml_desc_drop(xn->x_up);
+	xml_hash_drop(xn);
+    }
     xn->x_type = type;
+    if (old != type)
+	xml_index_link(xn->x_up, xn);
     return old;
 }
 
@@ -393,6 +694,9 @@ xml_child_i_set(cxobj *xt,
 		int    i, 
 		cxobj *xc)
 {
+    xml_index_drop(xt);
+    xml_desc_drop(xt);
+    xml_hash_drop(xt);
     if (i < xt->x_childvec_len)
 	xt->x_childvec[i] = xc;
     return 0;
@@ -438,19 +742,29 @@ xml_child_each(cxobj           *xparent,
 }
 
 /*! Extend child vector with one and insert xml node there
+ * The vector is doubled when full, so appending n children is O(n).
  * Note: does not do anything with child, you may need to set its parent, etc
  */
 static int
 xml_child_append(cxobj *x, 
 		 cxobj *xc)
 {
-    x->x_childvec_len++;
-    x->x_childvec = realloc(x->x_childvec, x->x_childvec_len*sizeof(cxobj*));
-    if (x->x_childvec == NULL){
-	clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
-	return -1;
+    cxobj **vec;
+    int     max;
+
+    xml_desc_drop(x);
+    xml_hash_drop(x);
+    if (x->x_childvec_len == x->x_childvec_max){
+	max = x->x_childvec_max?2*x->x_childvec_max:XML_CHILDVEC_MIN;
+	if ((vec = realloc(x->x_childvec, max*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
+	    return -1;
+	}
+	x->x_childvec = vec;
+	x->x_childvec_max = max;
     }
-    x->x_childvec[x->x_childvec_len-1] = xc;
+    x->x_childvec[x->x_childvec_len++] = xc;
+    xml_index_link(x, xc);
     return 0;
 }
 
@@ -465,7 +779,11 @@ int
 xml_childvec_set(cxobj *x, 
 		 int    len)
 {
+    xml_index_drop(x);
+    xml_desc_drop(x);
+    xml_hash_drop(x);
     x->x_childvec_len = len;
+    x->x_childvec_max = len;
     if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
 	clicon_err(OE_XML, errno, "calloc");
 	return -1;
@@ -496,13 +814,21 @@ cxobj *
 xml_new(char  *name, 
 	cxobj *xp)
 {
-    cxobj *xn;
+    cxobj            *xn;
+    struct xml_arena *xa = NULL;
 
-    if ((xn=malloc(sizeof(cxobj))) == NULL){
+    if (xp && xp->x_arena && xp->x_arena->xa_open){ /* Allocate in parent arena */
+	xa = xp->x_arena;
+	if ((xn = xml_arena_alloc(xa, sizeof(cxobj))) == NULL)
+	    return NULL;
+	xa->xa_refs++;
+    }
+    else if ((xn=malloc(sizeof(cxobj))) == NULL){
 	clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
 	return NULL;
     }
     memset(xn, 0, sizeof(cxobj));
+    xn->x_arena = xa;
     if ((xml_name_set(xn, name)) < 0)
 	return NULL;
 
@@ -513,6 +839,69 @@ xml_new(char  *name,
     return xn;
 }
 
+/*! Create new top-level xml node with a memory arena for the tree below it
+ *
+ * Nodes created below the node with xml_new() (eg by the parser or 
+ * xml_copy()), and their names and values, are allocated from large memory
+ * blocks of the arena instead of one malloc each. Close the arena with 
+ * xml_arena_close() when the tree is built, so that later changes of a 
+ * long-lived tree use malloc and can be freed.
+ * Free the tree with xml_free() as usual. The arena is freed when its last 
+ * node is freed, also if some nodes have been moved to another tree.
+ * @note Memory of nodes removed from a long-lived tree, eg a datastore cache,
+ * is not reclaimed until the whole tree (the arena) is freed.
+ * @param[in]  name      Name of new node
+ * @retval     xml       Created xml object if successful
+ * @retval     NULL      Error and clicon_err() called
+ * @code
+ *   cxobj *xt;
+ *   if ((xt = xml_new_arena("top")) == NULL)
+ *     err;
+ *   ... build tree with xml_new(name, xt), etc
+ *   xml_arena_close(xt);
+ *   xml_free(xt);
+ * @endcode
+ * @see xml_new
+ */
+cxobj *
+xml_new_arena(char *name)
+{
+    struct xml_arena *xa;
+    cxobj            *xn;
+
+    if ((xa = malloc(sizeof(*xa))) == NULL){
+	clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	return NULL;
+    }
+    memset(xa, 0, sizeof(*xa));
+    xa->xa_open = 1;
+    if ((xn = xml_arena_alloc(xa, sizeof(cxobj))) == NULL){
+	xml_arena_free(xa);
+	return NULL;
+    }
+    memset(xn, 0, sizeof(cxobj));
+    xn->x_arena = xa;
+    xa->xa_refs++;
+    if ((xml_name_set(xn, name)) < 0){
+	xml_free(xn);
+	return NULL;
+    }
+    return xn;
+}
+
+/*! Stop allocating new nodes and strings in the arena of a tree
+ * Nodes already allocated remain in the arena until freed.
+ * @param[in]  x   XML node, created by xml_new_arena() or below it
+ * @see xml_new_arena
+ */
+int
+xml_arena_close(cxobj *x)
+{
+    if (x->x_arena)
+	x->x_arena->xa_open = 0;
+    return 0;
+}
+
 /*! Create new xml node given a name, parent and spec. 
  * @param[in] name Name of new xml node
  * @param[in] xp   XML parent
@@ -550,6 +939,576 @@ xml_spec_set(cxobj *x,
     return 0;
 }
 
+/*! Compute key hash of an xml list or leaf-list entry
+ * @param[in]  x     XML list or leaf-list entry
+ * @param[in]  keys  Key names of list, NULL for leaf-list
+ * @param[out] hash  Hash of key values
+ * @retval     0     OK
+ * @retval     1     Key value missing, x cannot be indexed or matched
+ */
+static int
+xml_keyindex_hash(cxobj    *x,
+		  cvec     *keys,
+		  uint32_t *hash)
+{
+    uint32_t h = 2166136261u; /* FNV-1a */
+    cg_var  *cvi = NULL;
+    char    *b;
+
+    if (keys == NULL){
+	if ((b = xml_body(x)) == NULL)
+	    return 1;
+	for (; *b; b++)
+	    h = (h ^ (uint8_t)*b) * 16777619u;
+    }
+    else{
+	if (cvec_len(keys) == 0)
+	    return 1;
+	while ((cvi = cvec_each(keys, cvi)) != NULL) {
+	    if ((b = xml_find_body(x, cv_string_get(cvi))) == NULL)
+		return 1;
+	    for (; *b; b++)
+		h = (h ^ (uint8_t)*b) * 16777619u;
+	    h = (h ^ 0xff) * 16777619u; /* separator */
+	}
+    }
+    *hash = h;
+    return 0;
+}
+
+/*! Check if two xml list or leaf-list entries have same name and keys
+ * @see xml_keyindex_hash
+ */
+static int
+xml_keyindex_equal(cxobj *x0,
+		   cxobj *x1,
+		   cvec  *keys)
+{
+    cg_var  *cvi = NULL;
+    char    *b0;
+    char    *b1;
+
+    if (strcmp(x0->x_name, x1->x_name))
+	return 0;
+    if (keys == NULL){
+	if ((b0 = xml_body(x0)) == NULL || (b1 = xml_body(x1)) == NULL)
+	    return 0;
+	return strcmp(b0, b1) == 0;
+    }
+    if (cvec_len(keys) == 0)
+	return 0;
+    while ((cvi = cvec_each(keys, cvi)) != NULL) {
+	if ((b0 = xml_find_body(x0, cv_string_get(cvi))) == NULL ||
+	    (b1 = xml_find_body(x1, cv_string_get(cvi))) == NULL)
+	    return 0;
+	if (strcmp(b0, b1))
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Remove a key index from its parent and free it
+ * @param[in]  xp    XML parent
+ * @param[in]  xk    Key index of xp
+ */
+static void
+xml_keyindex_free(cxobj               *xp,
+		  struct xml_keyindex *xk)
+{
+    struct xml_keyindex **xkp;
+    uint32_t              i;
+
+    for (xkp = &xp->x_index; *xkp; xkp = &(*xkp)->xk_next)
+	if (*xkp == xk){
+	    *xkp = xk->xk_next;
+	    break;
+	}
+    for (i=0; i<xk->xk_size; i++)
+	if (xk->xk_slot[i])
+	    xk->xk_slot[i]->x_iflags &= ~XML_KEYINDEXED;
+    free(xk->xk_slot);
+    free(xk);
+}
+
+/*! Get key index of children of xp with a name
+ */
+static struct xml_keyindex *
+xml_keyindex_get(cxobj *xp,
+		 char  *name)
+{
+    struct xml_keyindex *xk;
+
+    for (xk = xp->x_index; xk; xk = xk->xk_next)
+	if (strcmp(xk->xk_name, name) == 0)
+	    break;
+    return xk;
+}
+
+/*! Check if xml node is a key leaf of an entry of a key index
+ */
+static int
+xml_keyindex_iskey(struct xml_keyindex *xk,
+		   cxobj               *x)
+{
+    cg_var *cvi = NULL;
+
+    if (x->x_type != CX_ELMNT)
+	return 0;
+    while ((cvi = cvec_each(xk->xk_keys, cvi)) != NULL)
+	if (strcmp(x->x_name, cv_string_get(cvi)) == 0)
+	    return 1;
+    return 0;
+}
+
+/*! Add an entry to a key index, unless its keys are missing or already indexed
+ * @param[in]  xk    Key index
+ * @param[in]  x     Entry, child of the indexed node with name of index
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_keyindex_insert(struct xml_keyindex *xk,
+		    cxobj               *x)
+{
+    cxobj   **slot;
+    cxobj    *xi;
+    uint32_t  size;
+    uint32_t  h;
+    uint32_t  i;
+    uint32_t  j;
+
+    if (x->x_type != CX_ELMNT || (x->x_iflags & XML_KEYINDEXED) ||
+	xml_keyindex_hash(x, xk->xk_keys, &h) != 0)
+	return 0;
+    if (2*(xk->xk_len+1) > xk->xk_size){ /* Grow and rehash */
+	size = xk->xk_size?2*xk->xk_size:16;
+	if ((slot = calloc(size, sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_XML, errno, "calloc");
+	    return -1;
+	}
+	for (j=0; j<xk->xk_size; j++){
+	    if ((xi = xk->xk_slot[j]) == NULL)
+		continue;
+	    xml_keyindex_hash(xi, xk->xk_keys, &i);
+	    for (i &= size-1; slot[i]; i = (i+1) & (size-1));
+	    slot[i] = xi;
+	}
+	free(xk->xk_slot);
+	xk->xk_slot = slot;
+	xk->xk_size = size;
+    }
+    for (i = h & (xk->xk_size-1); (xi = xk->xk_slot[i]) != NULL; 
+	 i = (i+1) & (xk->xk_size-1))
+	if (xml_keyindex_equal(xi, x, xk->xk_keys)){
+	    xk->xk_dups++;
+	    return 0;
+	}
+    xk->xk_slot[i] = x;
+    xk->xk_len++;
+    x->x_iflags |= XML_KEYINDEXED;
+    return 0;
+}
+
+/*! Remove an indexed entry from a key index
+ * The entry has the same key values as when it was added, since the index is
+ * removed if they change. If other entries have the same keys, the index is
+ * removed, since one of them should now be indexed instead.
+ * @param[in]  xp    XML parent
+ * @param[in]  xk    Key index of xp
+ * @param[in]  x     Indexed entry
+ */
+static void
+xml_keyindex_remove(cxobj               *xp,
+		    struct xml_keyindex *xk,
+		    cxobj               *x)
+{
+    cxobj    *xi;
+    uint32_t  mask = xk->xk_size-1;
+    uint32_t  h;
+    uint32_t  i;
+    uint32_t  j;
+
+    if (xk->xk_dups || xml_keyindex_hash(x, xk->xk_keys, &h) != 0){
+	xml_keyindex_free(xp, xk);
+	return;
+    }
+    for (i = h & mask; (xi = xk->xk_slot[i]) != NULL && xi != x; i = (i+1) & mask);
+    if (xi == NULL){
+	xml_keyindex_free(xp, xk);
+	return;
+    }
+    x->x_iflags &= ~XML_KEYINDEXED;
+    xk->xk_slot[i] = NULL;
+    xk->xk_len--;
+    /* Move back following entries of the probe sequence into the hole */
+    for (j = (i+1) & mask; (xi = xk->xk_slot[j]) != NULL; j = (j+1) & mask){
+	xml_keyindex_hash(xi, xk->xk_keys, &h);
+	h &= mask;
+	if (((j - h) & mask) >= ((j - i) & mask)){ /* hole is on probe path */
+	    xk->xk_slot[i] = xi;
+	    xk->xk_slot[j] = NULL;
+	    i = j;
+	}
+    }
+}
+
+/*! Update key indexes of ancestors since a node in an entry has changed
+ * The keys of an entry are its key leafs (list) or its body (leaf-list). If 
+ * they changed, an indexed entry makes the index invalid, and an entry not
+ * indexed may now be indexed.
+ * @param[in]  xe    Parent of changed node, possibly an entry
+ * @param[in]  xc    Changed node, child of xe
+ * @param[in]  add   0: before change, only remove index. 1: after change
+ */
+static void
+xml_index_touch(cxobj *xe,
+		cxobj *xc,
+		int    add)
+{
+    struct xml_keyindex *xk;
+    cxobj               *xp;
+    int                  d;
+
+    /* Entry is parent of key leaf (d=0) or grandparent of key body (d=1) */
+    for (d=0; d<2 && xe; d++, xc = xe, xe = xe->x_up){
+	if ((xp = xe->x_up) == NULL || xp->x_index == NULL)
+	    continue;
+	if ((xk = xml_keyindex_get(xp, xe->x_name)) == NULL)
+	    continue;
+	if (xk->xk_keys ? !xml_keyindex_iskey(xk, xc) : d > 0)
+	    continue;
+	if (xe->x_iflags & XML_KEYINDEXED)
+	    xml_keyindex_free(xp, xk);
+	else if (add && xml_keyindex_insert(xk, xe) < 0)
+	    xml_keyindex_free(xp, xk);
+    }
+}
+
+/*! Update key indexes after node has been added to parent or changed
+ * @param[in]  xp    Parent, or NULL
+ * @param[in]  xc    Added or changed child
+ */
+static void
+xml_index_link(cxobj *xp,
+	       cxobj *xc)
+{
+    struct xml_keyindex *xk;
+
+    if (xp == NULL)
+	return;
+    if (xp->x_index && xc->x_type == CX_ELMNT &&
+	(xk = xml_keyindex_get(xp, xc->x_name)) != NULL &&
+	xml_keyindex_insert(xk, xc) < 0)
+	xml_keyindex_free(xp, xk);
+    xml_index_touch(xp, xc, 1);
+}
+
+/*! Update key indexes before node is removed from parent or changed
+ * @param[in]  xp    Parent, or NULL
+ * @param[in]  xc    Removed or changed child
+ */
+static void
+xml_index_unlink(cxobj *xp,
+		 cxobj *xc)
+{
+    struct xml_keyindex *xk;
+
+    if (xp == NULL)
+	return;
+    if ((xc->x_iflags & XML_KEYINDEXED) &&
+	(xk = xml_keyindex_get(xp, xc->x_name)) != NULL)
+	xml_keyindex_remove(xp, xk, xc);
+    xml_index_touch(xp, xc, 0);
+}
+
+/*! Remove key indexes of node and of its closest ancestors
+ * Used when children are set directly, see xml_child_i_set. A key index of a
+ * node depends on its children (eg list entries), their children (key leafs)
+ * and their bodies, ie three levels down.
+ * @param[in]  x   xml node whose children have changed
+ */
+static void
+xml_index_drop(cxobj *x)
+{
+    int i;
+
+    for (i=0; i<4 && x; i++, x = x->x_up)
+	while (x->x_index)
+	    xml_keyindex_free(x, x->x_index);
+}
+
+/*! Find child of xp with same name and key values as x1 using a key index
+ *
+ * Lists are matched on key values, leaf-lists on body. The index of the 
+ * children with the name of x1 is built at first lookup, and kept up to date
+ * when children are added and removed, so that repeated lookups and inserts 
+ * among the same children (eg merge and diff) are O(1). A node has one index
+ * for each list or leaf-list name looked up among its children.
+ * @param[in]  xp      XML parent to search in
+ * @param[in]  x1      XML list or leaf-list entry to match (not child of xp)
+ * @param[in]  keys    Key names of list, or NULL for leaf-list. Part of yang
+ *                     spec, must be valid as long as xp
+ * @param[out] xmatch  Matching child of xp, or NULL if no match
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xml_find_keyed  which gets key names from yang
+ */
+int
+xml_find_keyindex(cxobj  *xp,
+		  cxobj  *x1,
+		  cvec   *keys,
+		  cxobj **xmatch)
+{
+    struct xml_keyindex *xk;
+    cxobj               *xc;
+    uint32_t             h;
+    uint32_t             i;
+    int                  j;
+
+    *xmatch = NULL;
+    if ((xk = xml_keyindex_get(xp, x1->x_name)) == NULL){
+	if (xp->x_childvec_len < XML_KEYINDEX_MIN){ /* Linear search */
+	    for (j=0; j<xp->x_childvec_len; j++){
+		xc = xp->x_childvec[j];
+		if (xc->x_type == CX_ELMNT && xml_keyindex_equal(xc, x1, keys)){
+		    *xmatch = xc;
+		    break;
+		}
+	    }
+	    return 0;
+	}
+	if ((xk = malloc(sizeof(*xk) + strlen(x1->x_name) + 1)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return -1;
+	}
+	memset(xk, 0, sizeof(*xk));
+	xk->xk_name = (char*)(xk + 1);
+	strcpy(xk->xk_name, x1->x_name);
+	xk->xk_keys = keys;
+	xk->xk_next = xp->x_index;
+	xp->x_index = xk;
+	for (j=0; j<xp->x_childvec_len; j++){
+	    xc = xp->x_childvec[j];
+	    if (xc->x_type == CX_ELMNT && strcmp(xc->x_name, xk->xk_name) == 0 &&
+		xml_keyindex_insert(xk, xc) < 0){
+		xml_keyindex_free(xp, xk);
+		return -1;
+	    }
+	}
+    }
+    if (xml_keyindex_hash(x1, keys, &h) != 0 || xk->xk_len == 0)
+	return 0;
+    for (i = h & (xk->xk_size-1); (xc = xk->xk_slot[i]) != NULL; 
+	 i = (i+1) & (xk->xk_size-1))
+	if (xml_keyindex_equal(xc, x1, keys)){
+	    *xmatch = xc;
+	    break;
+	}
+    return 0;
+}
+
+/*! Free a descendant name index
+ */
+static void
+xml_desc_free(clicon_hash_t *hash)
+{
+    char               *key;
+    struct xml_descvec *xd;
+
+    hash_each(hash, key){
+	if ((xd = hash_value(hash, key, NULL)) != NULL && xd->xd_vec)
+	    free(xd->xd_vec);
+    } hash_each_end();
+    hash_free(hash);
+}
+
+/*! Reset XML_DESC_NODE in a tree
+ */
+static void
+xml_desc_unmark(cxobj *x)
+{
+    int i;
+
+    x->x_iflags &= ~XML_DESC_NODE;
+    for (i=0; i<x->x_childvec_len; i++)
+	if (x->x_childvec[i]->x_iflags & XML_DESC_NODE)
+	    xml_desc_unmark(x->x_childvec[i]);
+}
+
+/*! Remove descendant name index of the tree of a node since the tree changed
+ * Names and types of all descendants are indexed, but not their values. 
+ * Only nodes marked with XML_DESC_NODE when the index was built are in an 
+ * indexed tree, so changes in other trees return directly. The marks are 
+ * reset with the index, which costs as much as building it.
+ * @param[in]  x   xml node whose name, type or children has changed, or NULL
+ * @see xml_find_descendants
+ */
+static void
+xml_desc_drop(cxobj *x)
+{
+    if (x == NULL || (x->x_iflags & XML_DESC_NODE) == 0)
+	return;
+    while (x->x_up)
+	x = x->x_up;
+    if (x->x_desc){
+	xml_desc_free(x->x_desc);
+	x->x_desc = NULL;
+    }
+    xml_desc_unmark(x);
+}
+
+/*! Add all descendant elements of x to a descendant name index
+ * @see xml_find_descendants
+ */
+static int
+xml_desc_build(clicon_hash_t *hash,
+	       cxobj         *x)
+{
+    int                 i;
+    cxobj              *xc;
+    struct xml_descvec *xd;
+    struct xml_descvec  xd0 = {NULL, 0};
+    clicon_hash_t       h;
+
+    for (i=0; i<x->x_childvec_len; i++){
+	xc = x->x_childvec[i];
+	if (xc->x_type != CX_ELMNT)
+	    continue;
+	if ((xd = hash_value(hash, xc->x_name, NULL)) == NULL){
+	    if ((h = hash_add(hash, xc->x_name, &xd0, sizeof(xd0))) == NULL)
+		return -1;
+	    xd = h->h_val;
+	}
+	if (cxvec_append(xc, &xd->xd_vec, &xd->xd_len) < 0)
+	    return -1;
+	xc->x_iflags |= XML_DESC_NODE;
+	if (xml_desc_build(hash, xc) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Find all descendant elements of an xml tree with a given name
+ * Uses an index of the descendants of the tree by name, which is built at
+ * the first call and kept until the tree changes. Repeated lookups in a tree 
+ * that is not modified, eg xpath //name, are then O(matches) instead of 
+ * O(tree). 
+ * @param[in]  xt      Top of xml tree, without parent
+ * @param[in]  name    Element name
+ * @param[out] vec     Matching elements in document order. Part of the 
+ *                     index, do not free. Valid until the tree changes.
+ * @param[out] veclen  Length of vec
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @code
+ *   cxobj **vec;
+ *   size_t  veclen;
+ *   if (xml_find_descendants(xt, "interface", &vec, &veclen) < 0)
+ *      goto err;
+ *   for (i=0; i<veclen; i++)
+ *      ...vec[i]
+ * @endcode
+ */
+int
+xml_find_descendants(cxobj   *xt,
+		     char    *name,
+		     cxobj ***vec,
+		     size_t  *veclen)
+{
+    int                 retval = -1;
+    struct xml_descvec *xd;
+
+    if (xt->x_up != NULL){
+	clicon_err(OE_XML, 0, "%s: %s is not top of tree", 
+		   __FUNCTION__, xt->x_name);
+	goto done;
+    }
+    if (xt->x_desc == NULL){
+	if ((xt->x_desc = hash_init()) == NULL)
+	    goto done;
+	xt->x_iflags |= XML_DESC_NODE;
+	if (xml_desc_build(xt->x_desc, xt) < 0){
+	    xml_desc_drop(xt);
+	    goto done;
+	}
+    }
+    if ((xd = hash_value(xt->x_desc, name, NULL)) != NULL){
+	*vec = xd->xd_vec;
+	*veclen = xd->xd_len;
+    }
+    else{
+	*vec = NULL;
+	*veclen = 0;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Reset content hash of node and its ancestors since the subtree changed
+ * If a hash is computed, hashes of all descendants are also computed, so the
+ * walk stops at the first ancestor without hash.
+ * @param[in]  x   xml node whose name, type, value or children has changed
+ * @see xml_hash
+ */
+static void
+xml_hash_drop(cxobj *x)
+{
+    for (; x && x->x_hash; x = x->x_up)
+	x->x_hash = 0;
+}
+
+/*! Add a null-terminated string, or NULL, to a FNV-1a hash */
+static uint64_t
+xml_hash_str(uint64_t h,
+	     char    *str)
+{
+    if (str == NULL)
+	return (h ^ 0x100) * XML_HASH_PRIME;
+    do {
+	h = (h ^ (unsigned char)*str) * XML_HASH_PRIME;
+    } while (*str++);
+    return h;
+}
+
+/*! Return a 64-bit content hash of an xml subtree
+ * The hash covers type, name and value of the node and, in order, the hashes
+ * of all children, including attributes and bodies. It is computed when
+ * needed and kept in the nodes until the subtree changes, so that repeated
+ * calls only visit changed parts of a tree. 
+ * Trees with different hashes differ. Trees with equal hashes are equal with
+ * high probability, eg to skip unchanged subtrees when comparing trees.
+ * @param[in]  x    xml node
+ * @retval     h    Hash value, never 0
+ * @see xml_diff
+ */
+uint64_t
+xml_hash(cxobj *x)
+{
+    uint64_t h;
+    uint64_t hc;
+    int      i;
+    int      j;
+    cxobj   *xc;
+
+    if (x->x_hash)
+	return x->x_hash;
+    h = (XML_HASH_OFFSET ^ x->x_type) * XML_HASH_PRIME;
+    h = xml_hash_str(h, x->x_name);
+    h = xml_hash_str(h, x->x_value);
+    for (i=0; i<x->x_childvec_len; i++){
+	if ((xc = x->x_childvec[i]) == NULL)
+	    continue;
+	hc = xml_hash(xc);
+	for (j=0; j<8; j++, hc >>= 8)
+	    h = (h ^ (hc & 0xff)) * XML_HASH_PRIME;
+    }
+    if (h == 0)
+	h = 1;
+    x->x_hash = h;
+    return h;
+}
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -568,7 +1527,7 @@ xml_find(cxobj *x_up,
     cxobj *x = NULL;
 
     while ((x = xml_child_each(x_up, x, -1)) != NULL) 
-	if (strcmp(name, xml_name(x)) == 0)
+	if (x->x_name == name || strcmp(name, x->x_name) == 0)
 	    return x;
     return NULL;
 }
@@ -684,6 +1643,9 @@ xml_child_rm(cxobj *xp,
 	clicon_err(OE_XML, 0, "Child not found");
 	goto done;
     }
+    xml_index_unlink(xp, xc);
+    xml_desc_drop(xp);
+    xml_hash_drop(xp);
     xp->x_childvec[i] = NULL;
     xml_parent_set(xc, NULL);
     xp->x_childvec_len--;
@@ -842,10 +1804,12 @@ xml_free(cxobj *x)
 {
     int i;
     cxobj *xc;
+    struct xml_arena *xa;
+    struct xml_keyindex *xk;
 
-    if (x->x_name)
+    if (x->x_name && (x->x_iflags & (XML_ARENA_NAME|XML_INTERN_NAME)) == 0)
 	free(x->x_name);
-    if (x->x_value)
+    if (x->x_value && (x->x_iflags & XML_ARENA_VALUE) == 0)
 	free(x->x_value);
     if (x->x_namespace)
 	free(x->x_namespace);
@@ -858,7 +1822,19 @@ xml_free(cxobj *x)
     }
     if (x->x_childvec)
 	free(x->x_childvec);
-    free(x);
+    while ((xk = x->x_index) != NULL){ /* Children are freed, dont unmark */
+	x->x_index = xk->xk_next;
+	free(xk->xk_slot);
+	free(xk);
+    }
+    if (x->x_desc)
+	xml_desc_free(x->x_desc);
+    if ((xa = x->x_arena) != NULL){
+	if (--xa->xa_refs == 0)
+	    xml_arena_free(xa);
+    }
+    else
+	free(x);
     return 0;
 }
 
@@ -988,6 +1964,240 @@ clicon_xml2cbuf(cbuf  *cb,
     return 0;
 }
 
+/*! Create a streaming xml output
+ * @param[in]  fd   File descriptor, eg socket, to write to. If -1, output is
+ *                  not written, only counted, see xml_stream_len
+ * @retval     xs   Xml stream. Free with xml_stream_free
+ * @retval     NULL Error
+ * @code
+ * xml_stream *xs;
+ * if ((xs = xml_stream_new(s)) == NULL)
+ *   goto err;
+ * if (clicon_xml2stream(xs, xn, 0, 0) < 0)
+ *   goto err;
+ * if (xml_stream_flush(xs) < 0)
+ *   goto err;
+ * xml_stream_free(xs);
+ * @endcode
+ */
+xml_stream *
+xml_stream_new(int fd)
+{
+    xml_stream *xs;
+
+    if ((xs = malloc(sizeof(*xs))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    memset(xs, 0, sizeof(*xs));
+    xs->xs_fd = fd;
+    return xs;
+}
+
+/*! Free a streaming xml output. Pending output is not flushed.
+ * @param[in]  xs   Xml stream
+ */
+int
+xml_stream_free(xml_stream *xs)
+{
+    free(xs);
+    return 0;
+}
+
+/*! Return total number of bytes streamed (written or pending) so far
+ * @param[in]  xs   Xml stream
+ */
+size_t
+xml_stream_len(xml_stream *xs)
+{
+    return xs->xs_len;
+}
+
+/*! Write all pending segments of an xml stream
+ * If the file descriptor is non-blocking and full, wait until it is writable.
+ * @param[in]  xs   Xml stream
+ * @retval     0    OK
+ * @retval    -1    Error, errno is set
+ */
+int
+xml_stream_flush(xml_stream *xs)
+{
+    struct iovec *iov = xs->xs_iov;
+    int           iovlen = xs->xs_iovlen;
+    ssize_t       n;
+    struct pollfd pfd;
+
+    if (xs->xs_fd == -1)
+	goto ok;
+    while (iovlen > 0){
+	if ((n = writev(xs->xs_fd, iov, iovlen)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno == EAGAIN || errno == EWOULDBLOCK){
+		pfd.fd = xs->xs_fd;
+		pfd.events = POLLOUT;
+		if (poll(&pfd, 1, -1) < 0 && errno != EINTR){
+		    clicon_err(OE_XML, errno, "poll");
+		    return -1;
+		}
+		continue;
+	    }
+	    clicon_err(OE_XML, errno, "writev");
+	    return -1;
+	}
+	/* Partial write: skip written segments and adjust first unwritten */
+	while (iovlen > 0 && n >= iov->iov_len){
+	    n -= iov->iov_len;
+	    iov++;
+	    iovlen--;
+	}
+	if (iovlen > 0){
+	    iov->iov_base = (char*)iov->iov_base + n;
+	    iov->iov_len -= n;
+	}
+    }
+ ok:
+    xs->xs_iovlen = 0;
+    xs->xs_pending = 0;
+    return 0;
+}
+
+/*! Append a string segment to an xml stream
+ * The string is not copied and must remain until the stream is flushed.
+ * @param[in]  xs   Xml stream
+ * @param[in]  str  String segment
+ * @param[in]  len  Length of segment
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_stream_str(xml_stream *xs, 
+	       char       *str, 
+	       size_t      len)
+{
+    if (len == 0)
+	return 0;
+    xs->xs_len += len;
+    if (xs->xs_fd == -1)
+	return 0;
+    xs->xs_iov[xs->xs_iovlen].iov_base = str;
+    xs->xs_iov[xs->xs_iovlen].iov_len = len;
+    xs->xs_iovlen++;
+    xs->xs_pending += len;
+    if (xs->xs_iovlen == XML_STREAM_IOV || xs->xs_pending >= XML_STREAM_CHUNK)
+	return xml_stream_flush(xs);
+    return 0;
+}
+
+/* Append constant or tree string to xml stream */
+#define xml_stream_cstr(xs, str) xml_stream_str((xs), (str), strlen(str))
+
+/*! Append indentation to an xml stream */
+static int
+xml_stream_indent(xml_stream *xs, 
+		  int         n)
+{
+    static char spaces[] = "                                "; /* 32 */
+    int         i;
+
+    for (i = n; i > 0; i -= sizeof(spaces)-1)
+	if (xml_stream_str(xs, spaces, i<sizeof(spaces)-1?i:sizeof(spaces)-1) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Stream an XML tree structure, eg directly to a socket
+ *
+ * Same output as clicon_xml2cbuf, but the output is written in chunks as the
+ * tree is traversed instead of built in memory.
+ * Note that pending output may point into the tree: the tree must not be
+ * modified or freed until xml_stream_flush has been called.
+ * @param[in]     xs          Xml stream
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @see clicon_xml2cbuf
+ */
+int
+clicon_xml2stream(xml_stream *xs, 
+		  cxobj      *x, 
+		  int         level, 
+		  int         prettyprint)
+{
+    int    retval = -1;
+    cxobj *xc;
+    char  *ns;
+
+    ns = xml_namespace(x);
+    switch(xml_type(x)){
+    case CX_BODY:
+	if (xml_value(x) && xml_stream_cstr(xs, xml_value(x)) < 0)
+	    goto done;
+	break;
+    case CX_ATTR:
+	if (xml_stream_cstr(xs, " ") < 0)
+	    goto done;
+	if (ns && (xml_stream_cstr(xs, ns) < 0 || xml_stream_cstr(xs, ":") < 0))
+	    goto done;
+	if (xml_stream_cstr(xs, xml_name(x)) < 0 ||
+	    xml_stream_cstr(xs, "=\"") < 0 ||
+	    (xml_value(x) && xml_stream_cstr(xs, xml_value(x)) < 0) ||
+	    xml_stream_cstr(xs, "\"") < 0)
+	    goto done;
+	break;
+    case CX_ELMNT:
+	if (prettyprint && xml_stream_indent(xs, level*XML_INDENT) < 0)
+	    goto done;
+	if (xml_stream_cstr(xs, "<") < 0)
+	    goto done;
+	if (ns && (xml_stream_cstr(xs, ns) < 0 || xml_stream_cstr(xs, ":") < 0))
+	    goto done;
+	if (xml_stream_cstr(xs, xml_name(x)) < 0)
+	    goto done;
+	xc = NULL;
+	/* print attributes only */
+	while ((xc = xml_child_each(x, xc, CX_ATTR)) != NULL) 
+	    if (clicon_xml2stream(xs, xc, level+1, prettyprint) < 0)
+		goto done;
+	/* Check for special case <a/> instead of <a></a> */
+	if (xml_body(x)==NULL && xml_child_nr_type(x, CX_ELMNT)==0){
+	    if (xml_stream_cstr(xs, "/>") < 0)
+		goto done;
+	}
+	else{
+	    if (xml_stream_cstr(xs, ">") < 0)
+		goto done;
+	    if (prettyprint && xml_body(x)==NULL && xml_stream_cstr(xs, "\n") < 0)
+		goto done;
+	    xc = NULL;
+	    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+		if (xml_type(xc) == CX_ATTR)
+		    continue;
+		if (clicon_xml2stream(xs, xc, level+1, prettyprint) < 0)
+		    goto done;
+	    }
+	    if (prettyprint && xml_body(x)==NULL && 
+		xml_stream_indent(xs, level*XML_INDENT) < 0)
+		goto done;
+	    if (xml_stream_cstr(xs, "</") < 0)
+		goto done;
+	    if (ns && (xml_stream_cstr(xs, ns) < 0 || xml_stream_cstr(xs, ":") < 0))
+		goto done;
+	    if (xml_stream_cstr(xs, xml_name(x)) < 0 ||
+		xml_stream_cstr(xs, ">") < 0)
+		goto done;
+	}
+	if (prettyprint && xml_stream_cstr(xs, "\n") < 0)
+	    goto done;
+	break;
+    default:
+	break;
+    }/* switch */
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Basic xml parsing function.
  * @param[in]  str   Pointer to string containing XML definition. 
  * @param[out] xtop  Top of XML parse tree. Assume created.
@@ -1070,6 +2280,191 @@ FSM(char *tag,
 	return 0;
 }
 
+/*! Scan a buffer for an endtag, continuing a previous scan
+ * @param[in]     buf     Buffer to scan
+ * @param[in]     len     Length of buffer
+ * @param[in]     endtag  Tag to scan for
+ * @param[in,out] state   FSM state, 0 initially
+ * @retval        n       Number of bytes up to and including endtag
+ * @retval        len     Endtag not found in buffer
+ */
+static size_t
+xml_endtag_scan(char   *buf,
+		size_t  len,
+		char   *endtag,
+		int    *state)
+{
+    size_t i;
+    int    endtaglen = strlen(endtag);
+
+    for (i=0; i<len; i++)
+	if ((*state = FSM(endtag, buf[i], *state)) == endtaglen)
+	    return i+1;
+    return len;
+}
+
+/*! Read XML text from a regular file until endtag in large blocks
+ * The rest of the file is read (or mmap:ed) in one go and the file offset is 
+ * then set to just after the endtag, as if it had been read one byte at a time.
+ * @param[in]  fd      Open file descriptor of a regular file
+ * @param[in]  st      File status of fd
+ * @param[in]  endtag  Read until endtag
+ * @param[out] bufp    Null-terminated XML text. Free after use
+ */
+static int
+xml_read_file(int          fd,
+	      struct stat *st,
+	      char        *endtag,
+	      char       **bufp)
+{
+    int    retval = -1;
+    off_t  off;
+    size_t size;     /* Remaining size of file */
+    size_t len = 0;  /* Bytes read into buf */
+    size_t n;        /* Bytes up to and including endtag */
+    char  *buf = NULL;
+    char  *map = MAP_FAILED;
+    ssize_t ret;
+    int    state = 0;
+
+    if ((off = lseek(fd, 0, SEEK_CUR)) < 0){
+	clicon_err(OE_XML, errno, "%s: lseek", __FUNCTION__);
+	goto done;
+    }
+    size = st->st_size > off ? st->st_size - off : 0;
+    if (size >= XML_MMAP_MIN &&
+	(map = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED){
+	n = xml_endtag_scan(map+off, size, endtag, &state);
+	if ((buf = malloc(n+1)) == NULL){
+	    clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	    goto done;
+	}
+	memcpy(buf, map+off, n);
+	len = n;
+    }
+    else{ /* mmap not applicable or failed: read */
+	if ((buf = malloc(size+1)) == NULL){
+	    clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	    goto done;
+	}
+	while (len < size){
+	    if ((ret = read(fd, buf+len, size-len)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_XML, errno, "%s: read", __FUNCTION__);
+		goto done;
+	    }
+	    if (ret == 0) /* File shrunk */
+		break;
+	    len += ret;
+	}
+	len = xml_endtag_scan(buf, len, endtag, &state);
+    }
+    buf[len] = '\0';
+    /* Leave file offset after endtag */
+    if (lseek(fd, off+len, SEEK_SET) < 0){
+	clicon_err(OE_XML, errno, "%s: lseek", __FUNCTION__);
+	goto done;
+    }
+    *bufp = buf;
+    buf = NULL;
+    retval = 0;
+ done:
+    if (map != MAP_FAILED)
+	munmap(map, st->st_size);
+    if (buf)
+	free(buf);
+    return retval;
+}
+
+/*! Read XML text from a stream (socket, pipe, tty) until endtag 
+ * Nothing after the endtag is consumed from the stream. For sockets, data is 
+ * peeked in blocks and only the bytes up to the endtag are then read. Other 
+ * streams cannot be peeked and are read one byte at a time.
+ * @param[in]  fd      Open file descriptor
+ * @param[in]  issock  fd is a socket
+ * @param[in]  endtag  Read until endtag
+ * @param[out] bufp    Null-terminated XML text. Free after use
+ * May block
+ */
+static int
+xml_read_stream(int    fd,
+		int    issock,
+		char  *endtag,
+		char **bufp)
+{
+    int     retval = -1;
+    char   *buf = NULL;
+    size_t  maxbuf = issock?XML_READ_BLOCK:BUFLEN;
+    size_t  len = 0;
+    size_t  n;
+    ssize_t ret;
+    int     state = 0;
+    int     state0;
+    int     endtaglen = strlen(endtag);
+
+    if ((buf = malloc(maxbuf)) == NULL){
+	clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+	goto done;
+    }
+    while (state != endtaglen){
+	if (len >= maxbuf-1){ /* Space: one for the null character */
+	    maxbuf *= 2;
+	    if ((buf = realloc(buf, maxbuf)) == NULL){
+		clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
+		goto done;
+	    }
+	}
+	if (issock){
+	    /* Peek what is available, then consume up to and including endtag */
+	    if ((ret = recv(fd, buf+len, maxbuf-len-1, MSG_PEEK)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_XML, errno, "%s: recv: [pid:%d]", 
+			   __FUNCTION__, (int)getpid());
+		goto done;
+	    }
+	    if (ret == 0)
+		break;
+	    state0 = state;
+	    n = xml_endtag_scan(buf+len, ret, endtag, &state);
+	    if ((ret = read(fd, buf+len, n)) < 0){
+		state = state0;
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_XML, errno, "%s: read: [pid:%d]", 
+			   __FUNCTION__, (int)getpid());
+		goto done;
+	    }
+	    if (ret < n){ /* Short read: rescan only what was consumed */
+		state = state0;
+		xml_endtag_scan(buf+len, ret, endtag, &state);
+	    }
+	}
+	else{
+	    if ((ret = read(fd, buf+len, 1)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_XML, errno, "%s: read: [pid:%d]", 
+			   __FUNCTION__, (int)getpid());
+		goto done;
+	    }
+	    if (ret == 0)
+		break;
+	    state = FSM(endtag, buf[len], state);
+	}
+	len += ret;
+    }
+    buf[len] = '\0';
+    *bufp = buf;
+    buf = NULL;
+    retval = 0;
+ done:
+    if (buf)
+	free(buf);
+    return retval;
+}
+
 /*! Read an XML definition from file and parse it into a parse-tree. 
  *
  * @param[in]  fd  A file descriptor containing the XML file (as ASCII characters)
@@ -1088,7 +2483,9 @@ FSM(char *tag,
  * Note, you need to free the xml parse tree after use, using xml_free()
  * Note, xt will add a top-level symbol called "top" meaning that <tree../> will look as:
  *  <top><tree.../></tree>
- * XXX: There is a potential leak here on some return values.
+ * Regular files are read in large blocks (or mmap:ed), sockets are peeked in
+ * blocks. In both cases nothing after endtag is consumed. Other streams, such
+ * as pipes, are read one byte at a time.
  * XXX: What happens if endtag is different?
  * May block
  */
@@ -1097,69 +2494,39 @@ clicon_xml_parse_file(int     fd,
 		      cxobj **cx, 
 		      char   *endtag)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   maxbuf = BUFLEN;
-    int   endtaglen = strlen(endtag);
-    int   state = 0;
-    int   oldmaxbuf;
+    int         retval = -1;
+    char       *xmlbuf = NULL;
+    struct stat st;
 
     if (endtag == NULL){
 	clicon_err(OE_XML, 0, "%s: endtag required\n", __FUNCTION__);
 	goto done;
     }
     *cx = NULL;
-    if ((xmlbuf = malloc(maxbuf)) == NULL){
-	clicon_err(OE_XML, errno, "%s: malloc", __FUNCTION__);
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_XML, errno, "%s: fstat", __FUNCTION__);
 	goto done;
     }
-    memset(xmlbuf, 0, maxbuf);
-    ptr = xmlbuf;
-    while (1){
-	if ((ret = read(fd, &ch, 1)) < 0){
-	    clicon_err(OE_XML, errno, "%s: read: [pid:%d]\n", 
-		    __FUNCTION__,
-		    (int)getpid());
-	    break;
-	}
-	if (ret != 0){
-	    state = FSM(endtag, ch, state);
-	    xmlbuf[len++] = ch;
-	}
-	if (ret == 0 || state == endtaglen){
-	    state = 0;
-	    if ((*cx = xml_new("top", NULL)) == NULL)
-		break;
-	    if (xml_parse(ptr, *cx) < 0){
-		goto done;
-	    }
-	    break;
-	}
-	if (len>=maxbuf-1){ /* Space: one for the null character */
-	    oldmaxbuf = maxbuf;
-	    maxbuf *= 2;
-	    if ((xmlbuf = realloc(xmlbuf, maxbuf)) == NULL){
-		clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
-		goto done;
-	    }
-	    memset(xmlbuf+oldmaxbuf, 0, maxbuf-oldmaxbuf);
-	    ptr = xmlbuf;
-	}
-    } /* while */
+    if (S_ISREG(st.st_mode)){
+	if (xml_read_file(fd, &st, endtag, &xmlbuf) < 0)
+	    goto done;
+    }
+    else if (xml_read_stream(fd, S_ISSOCK(st.st_mode), endtag, &xmlbuf) < 0)
+	goto done;
+    if ((*cx = xml_new_arena("top")) == NULL)
+	goto done;
+    if (xml_parse(xmlbuf, *cx) < 0)
+	goto done;
+    xml_arena_close(*cx);
     retval = 0;
  done:
     if (retval < 0 && *cx){
-	free(*cx);
+	xml_free(*cx);
 	*cx = NULL;
     }
     if (xmlbuf)
 	free(xmlbuf);
     return retval;
-    //    return (*cx)?0:-1;
 }
 
 /*! Read an XML definition from string and parse it into a parse-tree. 
@@ -1183,9 +2550,13 @@ int
 clicon_xml_parse_str(char   *str, 
 		     cxobj **cxtop)
 {
-  if ((*cxtop = xml_new("top", NULL)) == NULL)
+  int retval;
+
+  if ((*cxtop = xml_new_arena("top")) == NULL)
     return -1;
-  return xml_parse(str, *cxtop);
+  retval = xml_parse(str, *cxtop);
+  xml_arena_close(*cxtop);
+  return retval;
 }
 
 
@@ -1228,10 +2599,11 @@ clicon_xml_parse(cxobj **cxtop,
     va_start(args, format);
     len = vsnprintf(str, len, format, args) + 1;
     va_end(args);
-    if ((*cxtop = xml_new("top", NULL)) == NULL)
+    if ((*cxtop = xml_new_arena("top")) == NULL)
 	return -1;
     if (xml_parse(str, *cxtop) < 0)
 	goto done;
+    xml_arena_close(*cxtop);
     retval = 0;
  done:
     if (str)
@@ -1248,15 +2620,14 @@ copy_one(cxobj *xn0,
     cg_var *cv1;
 
     xml_type_set(xn1, xml_type(xn0));
-    if (xml_value(xn0)){ /* malloced string */
-	if ((xn1->x_value = strdup(xn0->x_value)) == NULL){
-	    clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
+    if (xml_value(xn0)) /* copied string */
+	if (xml_value_set(xn1, xml_value(xn0)) < 0)
 	    return -1;
-	}
-    }
-    if (xml_name(xn0)) /* malloced string */
+    if (xml_name(xn0) &&  /* copied string */
+	(xml_name(xn1) == NULL || strcmp(xml_name(xn0), xml_name(xn1))))
 	if ((xml_name_set(xn1, xml_name(xn0))) < 0)
 	    return -1;
+    xml_spec_set(xn1, xml_spec(xn0)); /* by reference */
     if (xml_cv_get(xn0)){
       if ((cv1 = cv_dup(xml_cv_get(xn0))) == NULL){
 	clicon_err(OE_XML, errno, "%s: cv_dup", __FUNCTION__);
@@ -1284,7 +2655,9 @@ xml_copy(cxobj *x0,
     int    retval = -1;
     cxobj *x;
     cxobj *xcopy;
+    int    empty;
 
+    empty = x1->x_childvec_len == 0;
     if (copy_one(x0, x1) <0)
 	goto done;
     x = NULL;
@@ -1294,6 +2667,8 @@ xml_copy(cxobj *x0,
 	if (xml_copy(x, xcopy) < 0) /* recursion */
 	    goto done;
     }
+    if (empty) /* Same content as x0 */
+	x1->x_hash = x0->x_hash;
     retval = 0;
   done:
     return retval;
@@ -1312,13 +2687,29 @@ xml_dup(cxobj *x0)
 {
     cxobj *x1;
 
-    if ((x1 = xml_new("new", NULL)) == NULL)
+    if ((x1 = xml_new_arena("new")) == NULL)
 	return NULL;
     if (xml_copy(x0, x1) < 0)
 	return NULL;
+    xml_arena_close(x1);
     return x1;
 }
 
+/*! Allocated length of an xml vector of a given length
+ * Vectors are allocated in powers of two, at least CXVEC_MIN.
+ * @see cxvec_append
+ */
+static size_t
+cxvec_max(size_t len)
+{
+    size_t max;
+
+    if (len == 0)
+	return 0;
+    for (max = CXVEC_MIN; max < len; max *= 2);
+    return max;
+}
+
 /*! Copy XML vector from vec0 to vec1
  * @param[in]  vec0    Source XML tree vector
  * @param[in]  len0    Length of source XML tree vector
@@ -1334,7 +2725,7 @@ cxvec_dup(cxobj  **vec0,
     int retval = -1;
 
     *len1 = len0;
-    if ((*vec1 = calloc(len0, sizeof(cxobj*))) == NULL)
+    if ((*vec1 = calloc(cxvec_max(len0), sizeof(cxobj*))) == NULL)
 	goto done;
     memcpy(*vec1, vec0, len0*sizeof(cxobj*));
     retval = 0;
@@ -1343,6 +2734,10 @@ cxvec_dup(cxobj  **vec0,
 }
 
 /*! Append a new xml tree to an existing xml vector
+ * The vector is doubled when full, so appending n trees is O(n). The 
+ * allocated length is given by the length, see cxvec_max. Therefore the 
+ * vector must be NULL or created by cxvec_append() or cxvec_dup(). It may 
+ * be shortened, but not reallocated by the caller.
  * @param[in]      x      XML tree (append this to vector)
  * @param[in,out]  vec    XML tree vector
  * @param[in,out]  len    Length of XML tree vector
@@ -1352,11 +2747,15 @@ cxvec_append(cxobj   *x,
 	     cxobj ***vec, 
 	     size_t  *len)
 {
-    int retval = -1;
+    int     retval = -1;
+    cxobj **v;
 
-    if ((*vec = realloc(*vec, sizeof(cxobj *) * (*len+1))) == NULL){
-	clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
-	goto done;
+    if (*len == cxvec_max(*len)){ /* Full */
+	if ((v = realloc(*vec, sizeof(cxobj *) * cxvec_max(*len+1))) == NULL){
+	    clicon_err(OE_XML, errno, "%s: realloc", __FUNCTION__);
+	    goto done;
+	}
+	*vec = v;
     }
     (*vec)[(*len)++] = x;
     retval = 0;
@@ -372,6 +372,48 @@ xmldb_get(clicon_handle h,
     return retval;
 }
 
+/*! Count a change of a database
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database that was changed
+ * @see xmldb_generation
+ */
+static int
+xmldb_changed(clicon_handle h, 
+	      char         *db)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    char           key[64];
+    uint32_t       gen;
+
+    snprintf(key, sizeof(key), "xmldb-gen-%s", db);
+    gen = xmldb_generation(h, db) + 1;
+    if (hash_add(cdat, key, &gen, sizeof(gen)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Get the change count of a database
+ * The count is increased by every put, copy, commit, delete and create of 
+ * the database made through this handle. Compare two values to see if the
+ * database was changed in between.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval     gen Number of changes of db
+ */
+uint32_t
+xmldb_generation(clicon_handle h, 
+		 char         *db)
+{
+    clicon_hash_t *cdat = clicon_data(h);
+    char           key[64];
+    uint32_t      *gen;
+
+    snprintf(key, sizeof(key), "xmldb-gen-%s", db);
+    if ((gen = hash_value(cdat, key, NULL)) == NULL)
+	return 0;
+    return *gen;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -426,7 +468,8 @@ xmldb_put(clicon_handle       h,
 	cbuf_free(cb);
     }
 #endif
-    retval = xa->xa_put_fn(xh, db, op, xt);
+    if ((retval = xa->xa_put_fn(xh, db, op, xt)) == 0)
+	retval = xmldb_changed(h, db);
  done:
     return retval;
 }
@@ -459,7 +502,47 @@ xmldb_copy(clicon_handle h,
 	clicon_err(OE_DB, 0, "Not connected to datastore plugin");
 	goto done;
     }
-    retval = xa->xa_copy_fn(xh, from, to);
+    if ((retval = xa->xa_copy_fn(xh, from, to)) == 0)
+	retval = xmldb_changed(h, to);
+ done:
+    return retval;
+}
+
+/*! Promote database from to database to, eg candidate to running
+ * After the call, to has the content of from, and from is unchanged. In 
+ * contrast to xmldb_copy, the datastore may share content between the 
+ * databases and replaces to atomically.
+ * If the datastore plugin has no commit function, xmldb_copy is used.
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database, eg "candidate"
+ * @param[in]  to    Destination database, eg "running"
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see xmldb_copy
+ */
+int 
+xmldb_commit(clicon_handle h, 
+	     char         *from, 
+	     char         *to)
+{
+    int               retval = -1;
+    xmldb_handle      xh;
+    struct xmldb_api *xa;
+
+    if ((xa = clicon_xmldb_api_get(h)) == NULL){
+	clicon_err(OE_DB, 0, "No xmldb plugin");
+	goto done;
+    }
+    if (xa->xa_commit_fn == NULL){
+	retval = xmldb_copy(h, from, to);
+	goto done;
+    }
+    if ((xh = clicon_xmldb_handle_get(h)) == NULL){
+	clicon_err(OE_DB, 0, "Not connected to datastore plugin");
+	goto done;
+    }
+    if ((retval = xa->xa_commit_fn(xh, from, to)) == 0)
+	retval = xmldb_changed(h, to);
  done:
     return retval;
 }
@@ -651,7 +734,8 @@ xmldb_delete(clicon_handle h,
 	clicon_err(OE_DB, 0, "Not connected to datastore plugin");
 	goto done;
     }
-    retval = xa->xa_delete_fn(xh, db);
+    if ((retval = xa->xa_delete_fn(xh, db)) == 0)
+	retval = xmldb_changed(h, db);
  done:
     return retval;
 }
@@ -682,7 +766,8 @@ xmldb_create(clicon_handle h,
 	clicon_err(OE_DB, 0, "Not connected to datastore plugin");
 	goto done;
     }
-    retval = xa->xa_create_fn(xh, db);
+    if ((retval = xa->xa_create_fn(xh, db)) == 0)
+	retval = xmldb_changed(h, db);
  done:
     return retval;
 }
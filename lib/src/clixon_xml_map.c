@@ -59,12 +59,14 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <ctype.h>
 #include <string.h>
 #include <arpa/inet.h>
 #include <assert.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <stdint.h>
 #include <netinet/in.h>
 
 /* cligen */
@@ -90,6 +92,13 @@
 /* Something to do with reverse engineering of junos syntax? */
 #undef SPECIAL_TREATMENT_OF_NAME  
 
+/*! Xml child and its position in yang order, see xml_order */
+struct xml_order_entry{
+    cxobj *xo_x;   /* Xml child */
+    int    xo_pos; /* Position of yang spec among data nodes of parent */
+    int    xo_i;   /* Original index, for a stable sort */
+};
+
 /*
  * A node is a leaf if it contains a body.
  */
@@ -627,16 +636,14 @@ xml_diff1(yang_stmt *ys,
     cxobj     *x1 = NULL;
     cxobj     *x2 = NULL;
     yang_stmt *y;
-    yang_stmt *ykey;
     char      *name;
-    cg_var    *cvi;
-    cvec      *cvk = NULL; /* vector of index keys */
-    char      *keyname;
-    int        equal;
     char      *body1;
     char      *body2;
 
     clicon_debug(2, "%s: %s", __FUNCTION__, ys->ys_argument?ys->ys_argument:"yspec");
+    /* Skip equal subtrees, only changed paths are traversed */
+    if (xml_hash(xt1) == xml_hash(xt2))
+	return 0;
     /* Check nodes present in xt1 and xt2 + nodes only in xt1
      * Loop over xt1
      */
@@ -653,46 +660,10 @@ xml_diff1(yang_stmt *ys,
 	}
 	switch (y->ys_keyword){
 	case Y_LIST:
-	    if ((ykey = yang_find((yang_node*)y, Y_KEY, NULL)) == NULL){
-		clicon_err(OE_XML, errno, "%s: List statement \"%s\" has no key", 
-			   __FUNCTION__, y->ys_argument);
-		goto done;
-	    }
-	    /* The value is a list of keys: <key>[ <key>]*  */
-	    if ((cvk = yang_arg2cvec(ykey, " ")) == NULL)
+	    /* Find a child in xt2 that matches name and keys */
+	    if (xml_find_keyed(xt2, x1, y, &x2) < 0)
 		goto done;
-	    /* Iterate over xt2 tree to (1) find a child that matches name
-	       (2) that have keys that matches */
-	    equal = 0;
-	    x2 = NULL;
-	    while ((x2 = xml_child_each(xt2, x2, CX_ELMNT)) != NULL){
-		if (strcmp(xml_name(x2), name))
-		    continue;
-		cvi = NULL;
-		equal = 0;
-		/* (2) Match keys between x1 and x2 */
-		while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-		    keyname = cv_string_get(cvi);
-		    if ((body1 = xml_find_body(x1, keyname)) == NULL)
-			continue; /* may be error */
-		    if ((body2 = xml_find_body(x2, keyname)) == NULL)
-			continue; /* may be error */
-		    if (strcmp(body1, body2)==0)
-			equal=1;
-		    else{
-			equal=0; /* stop as soon as inequal key found */
-			break;
-		    }
-		}
-		if (equal) /* found x1 and x2 equal, otherwise look 
-			      for other x2 */
-		    break;
-	    }
-	    if (cvk){
-		cvec_free(cvk);
-		cvk = NULL;
-	    }
-	    if (equal){ 
+	    if (x2 != NULL){ 
 		if (xml_diff1(y, x1, x2,   
 			      first, firstlen, 
 			      second, secondlen, 
@@ -703,7 +674,6 @@ xml_diff1(yang_stmt *ys,
 	    else
 		if (cxvec_append(x1, first, firstlen) < 0) 
 		    goto done;
-
 	    break;
 	case Y_CONTAINER:
 	    /* Equal regardless */
@@ -739,7 +709,9 @@ xml_diff1(yang_stmt *ys,
 	case Y_LEAF_LIST:
 	    if ((body1 = xml_body(x1)) == NULL)
 		continue;
-	    if (!xml_is_body(xt2, name, body1)) /* where body is */
+	    if (xml_find_keyed(xt2, x1, y, &x2) < 0)
+		goto done;
+	    if (x2 == NULL) /* where body is */
 		if (cxvec_append(x1, first, firstlen) < 0) 
 		    goto done;
 	    break;
@@ -763,46 +735,10 @@ xml_diff1(yang_stmt *ys,
 	}
 	switch (y->ys_keyword){
 	case Y_LIST:
-	    if ((ykey = yang_find((yang_node*)y, Y_KEY, NULL)) == NULL){
-		clicon_err(OE_XML, errno, "%s: List statement \"%s\" has no key", 
-			   __FUNCTION__, y->ys_argument);
+	    /* Find a child in xt1 that matches name and keys */
+	    if (xml_find_keyed(xt1, x2, y, &x1) < 0)
 		goto done;
-	    }
-	    /* The value is a list of keys: <key>[ <key>]*  */
-	    if ((cvk = yang_arg2cvec(ykey, " ")) == NULL)
-		goto done;
-	    /* Iterate over xt1 tree to (1) find a child that matches name
-	       (2) that have keys that matches */
-	    equal = 0;
-	    x1 = NULL;
-	    while ((x1 = xml_child_each(xt1, x1, CX_ELMNT)) != NULL){
-		if (strcmp(xml_name(x1), name))
-		    continue;
-		cvi = NULL;
-		equal = 0;
-		/* (2) Match keys between x2 and x1 */
-		while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-		    keyname = cv_string_get(cvi);
-		    if ((body2 = xml_find_body(x2, keyname)) == NULL)
-			continue; /* may be error */
-		    if ((body1 = xml_find_body(x1, keyname)) == NULL)
-			continue; /* may be error */
-		    if (strcmp(body2, body1)==0)
-			equal=1;
-		    else{
-			equal=0; /* stop as soon as inequal key found */
-			break;
-		    }
-		}
-		if (equal) /* found x1 and x2 equal, otherwise look 
-			      for other x2 */
-		    break;
-	    }
-	    if (cvk){
-		cvec_free(cvk);
-		cvk = NULL;
-	    }
-	    if (!equal)
+	    if (x1 == NULL)
 		if (cxvec_append(x2, second, secondlen) < 0) 
 		    goto done;
 	    break;
@@ -818,8 +754,9 @@ xml_diff1(yang_stmt *ys,
 		    goto done;
 	    break;
 	case Y_LEAF_LIST:
-	    body2 = xml_body(x2);
-	    if (!xml_is_body(xt1, name, body2)) /* where body is */
+	    if (xml_find_keyed(xt1, x2, y, &x1) < 0)
+		goto done;
+	    if (x1 == NULL) /* where body is */
 		if (cxvec_append(x2, second, secondlen) < 0) 
 		    goto done;
 	    break;
@@ -829,8 +766,6 @@ xml_diff1(yang_stmt *ys,
     } /* while xt1 */
     retval = 0;
  done:
-    if (cvk)
-	cvec_free(cvk);
     return retval;
 }
 
@@ -847,6 +782,7 @@ xml_diff1(yang_stmt *ys,
  * @param[out] changedlen Length of changed vector
  * All xml vectors should be freed after use.
  * Bot xml trees should be freed with xml_free()
+ * Subtrees with equal content hashes are not compared, see xml_hash.
  */
 int
 xml_diff(yang_spec *yspec, 
@@ -1300,110 +1236,228 @@ xml_tree_prune_flagged(cxobj *xt,
     return retval;
 }
 
+/*! Copy the marked parts of an xml tree into another tree
+ * Nodes flagged with XML_FLAG_MARK are copied with their complete sub-trees.
+ * Nodes flagged with XML_FLAG_CHANGE are ancestors of marked nodes: they are
+ * copied without their unmarked children, except list keys which are always
+ * copied so that the resulting list entries can be identified.
+ * This is the copying equivalent of xml_tree_prune_flagged_sub, it leaves x0
+ * intact and is useful when x0 is shared, eg a datastore cache.
+ * The copies of marked nodes are also flagged with XML_FLAG_MARK.
+ * @param[in]  x0  Source XML tree with marked nodes
+ * @param[in]  x1  Destination XML node, a created placeholder
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @code
+ *   xml_flag_set(x, XML_FLAG_MARK);
+ *   xml_apply_ancestor(x, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+ *   if (xml_copy_marked(x0t, x1t) < 0)
+ *      err;
+ * @endcode
+ * @see xml_tree_prune_flagged_sub
+ */
+int
+xml_copy_marked(cxobj *x0, 
+		cxobj *x1)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xcopy;
+    yang_stmt *yt;
+    int        iskey;
+
+    yt = xml_spec(x0); /* can be null */
+    /* Copy all attributes */
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ATTR)) != NULL) {
+	if ((xcopy = xml_new(xml_name(x), x1)) == NULL)
+	    goto done;
+	if (xml_copy(x, xcopy) < 0)
+	    goto done;
+    }
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL) {
+	if (xml_flag(x, XML_FLAG_MARK)){ /* Copy marked sub-tree */
+	    if ((xcopy = xml_new_spec(xml_name(x), x1, xml_spec(x))) == NULL)
+		goto done;
+	    if (xml_copy(x, xcopy) < 0) 
+		goto done;
+	    xml_flag_set(xcopy, XML_FLAG_MARK);
+	}
+	else if (xml_flag(x, XML_FLAG_CHANGE)){ /* Intermediate node */
+	    if ((xcopy = xml_new_spec(xml_name(x), x1, xml_spec(x))) == NULL)
+		goto done;
+	    if (xml_copy_marked(x, xcopy) < 0) /* recursion */
+		goto done;
+	}
+	else if (yt && yt->ys_keyword == Y_LIST){ /* List keys */
+	    if ((iskey = yang_key_match((yang_node*)yt, xml_name(x))) < 0)
+		goto done;
+	    if (iskey){
+		if ((xcopy = xml_new_spec(xml_name(x), x1, xml_spec(x))) == NULL)
+		    goto done;
+		if (xml_copy(x, xcopy) < 0) 
+		    goto done;
+	    }
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Add default values (if not set)
+ * The leaves with default values and their values are taken from the data
+ * node tables of the yang spec, and the children are traversed once to find
+ * which of them exist. New leaves are added last, see xml_order.
  * @param[in]   xt      XML tree with some node marked
  */
 int
 xml_default(cxobj *xt, 
 	   void   *arg)
 {
-    int        retval = -1;
-    yang_stmt *ys;
-    yang_stmt *y;
-    int        i;
-    cxobj     *xc;
-    cxobj     *xb;
-    char      *str;
+    int           retval = -1;
+    yang_stmt    *ys;
+    yang_stmt    *y;
+    yang_datatab *yt;
+    int           i;
+    int           pos;
+    cxobj        *xc;
+    cxobj        *xb;
+    char          buf[64];
+    char         *found = buf;   /* Default leaf i exists */
 
     if ((ys = (yang_stmt*)xml_spec(xt)) == NULL){
 	retval = 0;
 	goto done;
     }
     /* Check leaf defaults */
-    if (ys->ys_keyword == Y_CONTAINER || ys->ys_keyword == Y_LIST){
-	for (i=0; i<ys->ys_len; i++){
-	    y = ys->ys_stmt[i];
-	    if (y->ys_keyword != Y_LEAF)
-		continue;
-	    assert(y->ys_cv);
-	    if (!cv_flag(y->ys_cv, V_UNSET)){  /* Default value exists */
-		if (!xml_find(xt, y->ys_argument)){
-		    if ((xc = xml_new_spec(y->ys_argument, xt, y)) == NULL)
-			goto done;
-		    if ((xb = xml_new("body", xc)) == NULL)
-			goto done;
-		    xml_type_set(xb, CX_BODY);
-		    if ((str = cv2str_dup(y->ys_cv)) == NULL){
-			clicon_err(OE_UNIX, errno, "cv2str_dup");
-			goto done;
-		    }
-		    if (xml_value_set(xb, str) < 0)
-			goto done;
-		    free(str);
-		}
-	    }
-	}
+    if (ys->ys_keyword != Y_CONTAINER && ys->ys_keyword != Y_LIST){
+	retval = 0;
+	goto done;
+    }
+    if ((yt = yang_datatab_get(ys)) == NULL)
+	goto done;
+    if (yt->yt_deflen == 0){
+	retval = 0;
+	goto done;
+    }
+    if (yt->yt_deflen > sizeof(buf) && 
+	(found = malloc(yt->yt_deflen)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(found, 0, yt->yt_deflen);
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+	if ((y = (yang_stmt*)xml_spec(xc)) == NULL &&
+	    (y = yang_find_datanode((yang_node*)ys, xml_name(xc))) == NULL)
+	    continue;
+	if ((pos = yang_order(ys, y)) >= 0 && yt->yt_defidx[pos] >= 0)
+	    found[yt->yt_defidx[pos]] = 1;
+    }
+    for (i=0; i<yt->yt_deflen; i++){
+	if (found[i])
+	    continue;
+	y = yt->yt_defleaf[i];
+	if ((xc = xml_new_spec(y->ys_argument, xt, y)) == NULL)
+	    goto done;
+	if ((xb = xml_new("body", xc)) == NULL)
+	    goto done;
+	xml_type_set(xb, CX_BODY);
+	if (xml_value_set(xb, yt->yt_defbody[i]) < 0)
+	    goto done;
     }
     retval = 0;
  done:
+    if (found != buf)
+	free(found);
     return retval;
 }
 
+/*! Position of an xml child in yang order, see xml_order */
+static int
+xml_order_pos(yang_stmt *ys,
+	      cxobj     *xc)
+{
+    yang_stmt *yc;
+    int        pos;
+
+    if (xml_type(xc) != CX_ELMNT) /* Attributes etc first */
+	return -1;
+    if ((yc = (yang_stmt*)xml_spec(xc)) == NULL &&
+	(yc = yang_find_datanode((yang_node*)ys, xml_name(xc))) == NULL)
+	return INT_MAX;
+    if ((pos = yang_order(ys, yc)) < 0) /* Unknown elements last */
+	return INT_MAX;
+    return pos;
+}
+
+/*! Compare position, then original index, of two xml children to order */
+static int
+xml_order_cmp(const void *a,
+	      const void *b)
+{
+    const struct xml_order_entry *xa = a;
+    const struct xml_order_entry *xb = b;
+
+    if (xa->xo_pos != xb->xo_pos)
+	return xa->xo_pos < xb->xo_pos ? -1 : 1;
+    return xa->xo_i - xb->xo_i;
+}
+
 /*! Order XML children according to YANG
+ * Stable sort of the children on the position of their yang spec among the 
+ * data nodes of the parent, so that entries of a list keep their order.
+ * Children that are already ordered, the common case, are only checked.
  * @param[in]   xt      XML top of tree
  */
 int
 xml_order(cxobj *xt, 
 	  void  *arg)
 {
-    int        retval = -1;
-    yang_stmt *y;
-    yang_stmt *yc;
-    int        i;
-    int        j0;
-    int        j;
-    cxobj     *xc;
-    cxobj     *xj;
-    char      *yname; /* yang child name */
-    char      *xname; /* xml child name */
-
-    if ((y = (yang_stmt*)xml_spec(xt)) == NULL){
+    int                     retval = -1;
+    yang_stmt              *y;
+    int                     i;
+    int                     n;
+    int                     pos;
+    int                     prev;
+    struct xml_order_entry *vec = NULL;
+
+    if ((y = (yang_stmt*)xml_spec(xt)) == NULL ||
+	(n = xml_child_nr(xt)) < 2){
 	retval = 0;
 	goto done;
     }
-    j0 = 0;
- /* Go through xml children and ensure they are same order as yspec children */
-    for (i=0; i<y->ys_len; i++){
-	yc = y->ys_stmt[i];
-	if (!yang_datanode(yc))
-	    continue;
-	yname = yc->ys_argument;
-	/* First go thru xml children with same name */
-	for (; j0<xml_child_nr(xt); j0++){
-	    xc = xml_child_i(xt, j0);
-	    if (xml_type(xc) != CX_ELMNT)
-		continue;
-	    xname = xml_name(xc);
-	    if (strcmp(xname, yname))
-		break;
-	}
-	/* Now we have children not with same name */
-	for (j=j0; j<xml_child_nr(xt); j++){
-	    xc = xml_child_i(xt, j);
-	    if (xml_type(xc) != CX_ELMNT)
-		continue;
-	    xname = xml_name(xc);
-	    if (strcmp(xname, yname))
-		continue;
-	    /* reorder */
-	    xj = xml_child_i(xt, j0);
-	    xml_child_i_set(xt, j0, xc);
-	    xml_child_i_set(xt, j, xj);
-	    j0++;
-	}
+    if (yang_datatab_get(y) == NULL)
+	goto done;
+    prev = -1;
+    for (i=0; i<n; i++){
+	if ((pos = xml_order_pos(y, xml_child_i(xt, i))) < prev)
+	    break;
+	prev = pos;
+    }
+    if (i == n){ /* Already ordered */
+	retval = 0;
+	goto done;
+    }
+    if ((vec = malloc(n*sizeof(*vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
     }
+    for (i=0; i<n; i++){
+	vec[i].xo_x = xml_child_i(xt, i);
+	vec[i].xo_pos = xml_order_pos(y, vec[i].xo_x);
+	vec[i].xo_i = i;
+    }
+    qsort(vec, n, sizeof(*vec), xml_order_cmp);
+    for (i=0; i<n; i++)
+	if (xml_child_i(xt, i) != vec[i].xo_x)
+	    xml_child_i_set(xt, i, vec[i].xo_x);
     retval = 0;
  done:
+    if (vec)
+	free(vec);
     return retval;
 }
 
@@ -1458,6 +1512,85 @@ xml_non_config_data(cxobj *xt,
     return retval;
 }
 
+/*! Recursive help function of xml_finalize
+ * @param[in]  xt      XML tree node
+ * @param[in]  ops     XML_FINALIZE_* operations
+ * @param[in]  inside  Node is inside a selected subtree
+ */
+static int
+xml_finalize1(cxobj *xt,
+	      int    ops,
+	      int    inside)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xprev;
+    yang_stmt *ys;
+    int        in;
+
+    x = NULL;
+    xprev = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	ys = (yang_stmt*)xml_spec(x);
+	if ((ops & XML_FINALIZE_CONFIG) && ys && !yang_config(ys)){
+	    if (xml_purge(x) < 0) /* State data */
+		goto done;
+	    x = xprev;
+	    continue;
+	}
+	in = inside;
+	if ((ops & XML_FINALIZE_MARKED) && xml_flag(x, XML_FLAG_MARK)){
+	    xml_flag_reset(x, XML_FLAG_MARK);
+	    in = 1;
+	}
+	if ((ops & XML_FINALIZE_SANITY) && xml_sanity(x, NULL) < 0)
+	    goto done;
+	if (xml_finalize1(x, ops, in) < 0)
+	    goto done;
+	if ((ops & XML_FINALIZE_DEFAULT) && in && xml_default(x, NULL) < 0)
+	    goto done;
+	if ((ops & XML_FINALIZE_ORDER) && xml_order(x, NULL) < 0)
+	    goto done;
+	xprev = x;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove state data, add defaults and order an xml tree in a single walk
+ * Equivalent to, but faster than, the sequence:
+ * @code
+ *   xml_apply(xt, CX_ELMNT, xml_non_config_data, NULL);
+ *   xml_tree_prune_flagged(xt, XML_FLAG_MARK, 1);
+ *   xml_apply(xt, CX_ELMNT, xml_default, NULL);
+ *   xml_apply(xt, CX_ELMNT, xml_order, NULL);
+ *   xml_apply(xt, CX_ELMNT, xml_sanity, NULL);
+ * @endcode
+ * Each node is visited once: state children are removed before the node is
+ * traversed, and defaults are added and children ordered after.
+ * With XML_FINALIZE_MARKED, eg for the result of an xpath, defaults are only
+ * added in subtrees flagged with XML_FLAG_MARK, or everywhere if xt is 
+ * flagged, not in their ancestors, and the flags are reset. Ancestors are 
+ * still ordered so that eg list keys come first.
+ * @param[in]  xt   XML tree. The top node itself is not changed
+ * @param[in]  ops  XML_FINALIZE_* operations
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_finalize(cxobj *xt,
+	     int    ops)
+{
+    int inside = 1;
+
+    if (ops & XML_FINALIZE_MARKED){
+	inside = xml_flag(xt, XML_FLAG_MARK) != 0;
+	xml_flag_reset(xt, XML_FLAG_MARK);
+    }
+    return xml_finalize1(xt, ops, inside);
+}
+
 /*! Add yang specification backpoint to XML node
  * @param[in]   xt      XML tree node
  * @note This should really be unnecessary since yspec should be set on creation
@@ -1833,6 +1966,35 @@ api_path2xml(char       *api_path,
     return retval;
 }
 
+/*! Find child of xp with same name and key values as x1 using a key index
+ *
+ * Lists are matched on key values, leaf-lists on body. The index is built
+ * at first lookup and kept in xp, and updated as children are added and
+ * removed, so that repeated lookups and inserts among the same children 
+ * (eg merge and diff) are O(1).
+ * @param[in]  xp      XML parent to search in
+ * @param[in]  x1      XML list or leaf-list entry to match (not child of xp)
+ * @param[in]  y       Yang list or leaf-list of x1
+ * @param[out] xmatch  Matching child of xp, or NULL if no match
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xml_find_keyindex
+ */
+int
+xml_find_keyed(cxobj     *xp,
+	       cxobj     *x1,
+	       yang_stmt *y,
+	       cxobj    **xmatch)
+{
+    cvec *cvk = NULL; /* Key names, part of yang, dont free */
+
+    *xmatch = NULL;
+    if (y->ys_keyword == Y_LIST &&
+	(cvk = yang_key_cvec(y)) == NULL)
+	return -1;
+    return xml_find_keyindex(xp, x1, cvk, xmatch);
+}
+
 /*! Given a modification tree, check existing matching child in the base tree 
  * param[in] x0    Base tree node
  * param[in] x1c   Modification tree child
@@ -1847,56 +2009,14 @@ match_base_child(cxobj     *x0,
 {
     int        retval = -1;
     cxobj     *x0c = NULL;
-    char      *keyname;
-    cvec      *cvk = NULL;
-    cg_var    *cvi;
-    char      *b0;
-    char      *b1;
-    yang_stmt *ykey;
     char      *cname;
-    int        ok;
-    char      *x1bstr; /* body string */
 
     cname = xml_name(x1c);
     switch (yc->ys_keyword){
     case Y_LEAF_LIST: /* Match with name and value */
-	x1bstr = xml_body(x1c);
-	x0c = NULL;
-	while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
-	    if (strcmp(cname, xml_name(x0c)) == 0 && 
-		strcmp(xml_body(x0c), x1bstr)==0)
-		break;
-	}
-	break;
     case Y_LIST: /* Match with key values */
-	if ((ykey = yang_find((yang_node*)yc, Y_KEY, NULL)) == NULL){
-	    clicon_err(OE_XML, errno, "%s: List statement \"%s\" has no key", 
-		       __FUNCTION__, yc->ys_argument);
+	if (xml_find_keyed(x0, x1c, yc, &x0c) < 0)
 	    goto done;
-	}
-	/* The value is a list of keys: <key>[ <key>]*  */
-	if ((cvk = yang_arg2cvec(ykey, " ")) == NULL)
-	    goto done;
-	x0c = NULL;
-	while ((x0c = xml_child_each(x0, x0c, CX_ELMNT)) != NULL) {
-	    if (strcmp(xml_name(x0c), cname))
-		continue;
-	    cvi = NULL;
-	    ok = 0;
-	    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-		keyname = cv_string_get(cvi);
-		ok = 1; /* if we come here */
-		if ((b0 = xml_find_body(x0c, keyname)) == NULL)
-		    break; /* error case */
-		if ((b1 = xml_find_body(x1c, keyname)) == NULL)
-		    break; /* error case */
-		if (strcmp(b0, b1))
-		    break;
-		ok = 2; /* and reaches here for all keynames, x0c is found. */
-	    }
-	    if (ok == 2)
-		break;
-	}
 	break;
     default: /* Just match with name */
 	x0c = xml_find(x0, cname);
@@ -1905,8 +2025,6 @@ match_base_child(cxobj     *x0,
     *x0cp = x0c;
     retval = 0;
  done:
-    if (cvk)
-	cvec_free(cvk);
     return retval;
 }
 
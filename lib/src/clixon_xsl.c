@@ -100,12 +100,21 @@ in
 /* clicon */
 #include "clixon_err.h"
 #include "clixon_log.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
 #include "clixon_string.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_plugin.h"
+#include "clixon_options.h"
 #include "clixon_xml.h"
 #include "clixon_xsl.h"
+#include "clixon_xml_map.h"
 
 /* Constants */
 #define XPATH_VEC_START 128
+#define XPATH_CACHE_MAX 256 /* Max number of compiled xpaths in cache */
+#define XPATH_UNIQUE_MIN 8  /* Remove duplicates using a hash set from this length */
 
 
 /*
@@ -142,9 +151,29 @@ static const map_str2int axismap[] = {
     {NULL,               -1}
 };
 
+/* How a step matches node names, see xpath_name_match */
+enum xpath_match{
+    XE_EXACT,   /* Plain name: strcmp, or pointer compare if interned */
+    XE_ANY,     /* "*": all names */
+    XE_GLOB,    /* Shell wildcard pattern: fnmatch */
+};
+
+/* Predicate expression types, see xpath_expr */
+enum xpath_pred_type{
+    XP_ATTR,    /* @<attr> or @<attr>=<value> */
+    XP_INDEX,   /* <number> */
+    XP_EQ,      /* <name>=<value> */
+    XP_CURRENT, /* <name>=current()<xpath> */
+};
+
 struct xpath_predicate{
     struct xpath_predicate *xp_next;
-    char                   *xp_expr;
+    char                   *xp_expr;  /* Original expression */
+    enum xpath_pred_type    xp_type;
+    int                     xp_index; /* XP_INDEX */
+    char                   *xp_name;  /* Attribute or child name */
+    char                   *xp_value; /* Value, or NULL if only @<attr> */
+    struct xpath_element   *xp_path;  /* XP_CURRENT: path relative current() */
 };
 
 struct xpath_element{
@@ -152,10 +181,32 @@ struct xpath_element{
     enum axis_type          xe_type;
     char                   *xe_prefix; /* eg for namespaces */
     char                   *xe_str; /* eg for child */
+    enum xpath_match        xe_match; /* How xe_str matches names */
+    char                   *xe_iname; /* XE_EXACT: interned xe_str, or NULL */
     struct xpath_predicate *xe_predicate; /* eg within [] */
 };
 
+/* Compiled xpath: alternatives separated by " | " */
+struct xpath_comp{
+    int                    xc_len;
+    struct xpath_element **xc_vec;
+};
+
+/* Entry in cache of compiled xpaths */
+struct xpath_cache{
+    qelem_t     xy_qelem;  /* LRU list, most recently used first */
+    char       *xy_str;    /* Xpath string, also hash key */
+    xpath_comp *xy_xc;     /* Compiled xpath */
+};
+
+/* Cache of compiled xpaths, see xpath_cache_get */
+static clicon_hash_t      *xpath_cache_hash = NULL;
+static struct xpath_cache *xpath_cache_list = NULL;
+static int                 xpath_cache_len = 0;
+
 static int xpath_split(char *xpathstr, char **pathexpr);
+static int xpath_parse(char *xpath, struct xpath_element **xplist0);
+static int xpath_free(struct xpath_element *xplist);
 
 static int 
 xpath_print(FILE *f, struct xpath_element *xplist)
@@ -172,6 +223,77 @@ xpath_print(FILE *f, struct xpath_element *xplist)
     return 0;
 }
 
+/*! Compile a predicate expression into its type and operands
+ * The predicate expression is a subset of the standard, see xpath_expr
+ * @param[in,out] xp  Predicate with xp_expr set
+ */
+static int
+xpath_predicate_compile(struct xpath_predicate *xp)
+{
+    int   retval = -1;
+    char *e0 = NULL;
+    char *e;
+    char *tag;
+    char *path;
+
+    if ((e0 = strdup(xp->xp_expr)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    e = e0;
+    if (*e == '@'){ /* @ attribute */
+	e++;
+	tag = strsep(&e, "=");
+	xp->xp_type = XP_ATTR;
+	if ((xp->xp_name = strdup(tag)) == NULL ||
+	    (e && (xp->xp_value = strdup(e)) == NULL)){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+    }
+    else if (strlen(e+strcspn(e, "="))==0){ /* no operator */
+	if (sscanf(e, "%d", &xp->xp_index) != 1){
+	    clicon_err(OE_XML, errno, "%s: malformed expression: [%s]", 
+		       __FUNCTION__, e);
+	    goto done;
+	}
+	xp->xp_type = XP_INDEX;
+    }
+    else{ /* <tag><op><value>, where <op>='=' for now */
+	tag = strsep(&e, "=");
+	/* Strip trailing spaces */
+	while (strlen(tag) && tag[strlen(tag)-1] == ' ')
+	    tag[strlen(tag)-1] = '\0';
+	/* Strip heading spaces */
+	while (e[0]==' ')
+	    e++;
+	if ((xp->xp_name = strdup(tag)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if (strncmp(e, "current()", strlen("current()")) == 0){
+	    /* name = current()xpath, evaluate as .xpath */
+	    path = e + strlen("current(");
+	    *path = '.';
+	    if (xpath_parse(path, &xp->xp_path) < 0)
+		goto done;
+	    xp->xp_type = XP_CURRENT;
+	}
+	else{
+	    if ((xp->xp_value = strdup(e)) == NULL){
+		clicon_err(OE_UNIX, errno, "strdup");
+		goto done;
+	    }
+	    xp->xp_type = XP_EQ;
+	}
+    }
+    retval = 0;
+ done:
+    if (e0)
+	free(e0);
+    return retval;
+}
+
 /*! Extract PredicateExpr (Expr) from a Predicate within [] 
  * @see xpath_expr  For evaluation of predicate 
  */
@@ -199,12 +321,14 @@ xpath_parse_predicate(struct xpath_element *xe,
 		goto done;
 	    }	
 	    memset(xp, 0, sizeof(*xp));    
+	    xp->xp_next = xe->xe_predicate;
+	    xe->xe_predicate = xp;
 	    if ((xp->xp_expr = strdup(s)) == NULL){	    
 		clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
 		goto done;
 	    }
-	    xp->xp_next = xe->xe_predicate;
-	    xe->xe_predicate = xp;
+	    if (xpath_predicate_compile(xp) < 0)
+		goto done;
 	}
     }
     retval = 0;
@@ -218,7 +342,7 @@ xpath_element_new(enum axis_type          atype,
 		  struct xpath_element ***xpnext)
 {
     int                     retval = -1;
-    struct xpath_element   *xe;
+    struct xpath_element   *xe = NULL;
     char                   *str1 = NULL;
     char                   *pred;
     char                   *local;
@@ -259,15 +383,26 @@ xpath_element_new(enum axis_type          atype,
 		goto done;
 	    }
 	}
+	if (strcmp(xe->xe_str, "*") == 0)
+	    xe->xe_match = XE_ANY;
+	else if (strpbrk(xe->xe_str, "*?[\\") != NULL)
+	    xe->xe_match = XE_GLOB;
+	else{
+	    xe->xe_match = XE_EXACT;
+	    xe->xe_iname = clicon_intern_find(xe->xe_str);
+	}
 	if (pred && strlen(pred)){
 	    if (xpath_parse_predicate(xe, pred) < 0)
 		goto done;
 	}
     }
-    (**xpnext) = xe;
-    *xpnext = &xe->xe_next;
     retval = 0;
  done:
+    /* Link also on error, so that it is freed with the list */
+    if (xe){
+	(**xpnext) = xe;
+	*xpnext = &xe->xe_next;
+    }
     if (str1)
 	free(str1);
     return retval;
@@ -286,6 +421,12 @@ xpath_element_free(struct xpath_element *xe)
 	xe->xe_predicate = xp->xp_next;
 	if (xp->xp_expr)
 	    free(xp->xp_expr);
+	if (xp->xp_name)
+	    free(xp->xp_name);
+	if (xp->xp_value)
+	    free(xp->xp_value);
+	if (xp->xp_path)
+	    xpath_free(xp->xp_path);
 	free(xp);
     }
     free(xe);
@@ -319,6 +460,7 @@ xpath_parse(char                  *xpath,
     struct xpath_element  *xplist = NULL;
     struct xpath_element **xpnext = &xplist;
     int                    esc = 0;
+    int                    ret;
 
     if ((s0 = strdup(xpath)) == NULL){
 	clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
@@ -353,38 +495,40 @@ xpath_parse(char                  *xpath,
     s = s0;
     for (i=0; i<nvec; i++){
 	if ((i==0 && strcmp(s,"")==0)) /* Initial / or // */
-	    xpath_element_new(A_ROOT, NULL, &xpnext);
+	    ret = xpath_element_new(A_ROOT, NULL, &xpnext);
 	else if (i!=nvec-1 && strcmp(s,"")==0)
-	    xpath_element_new(A_DESCENDANT_OR_SELF, NULL, &xpnext);
+	    ret = xpath_element_new(A_DESCENDANT_OR_SELF, NULL, &xpnext);
 	else if (strncmp(s,"descendant-or-self::", strlen("descendant-or-self::"))==0){ 
-	    xpath_element_new(A_DESCENDANT_OR_SELF, s+strlen("descendant-or-self::"), &xpnext);
+	    ret = xpath_element_new(A_DESCENDANT_OR_SELF, s+strlen("descendant-or-self::"), &xpnext);
 	}
 #if 1
 	else if (strncmp(s,"..", strlen(".."))==0) /* abbreviatedstep */
-	    xpath_element_new(A_PARENT, s+strlen(".."), &xpnext);
+	    ret = xpath_element_new(A_PARENT, s+strlen(".."), &xpnext);
 #else
 	else if (strncmp(s,"..", strlen(s))==0) /* abbreviatedstep */
-	    xpath_element_new(A_PARENT, NULL, &xpnext);
+	    ret = xpath_element_new(A_PARENT, NULL, &xpnext);
 #endif
 #if 1 /* Problems with .[userid=1321] */
 	else if (strncmp(s,".", strlen("."))==0)
-	    xpath_element_new(A_SELF, s+strlen("."), &xpnext);
+	    ret = xpath_element_new(A_SELF, s+strlen("."), &xpnext);
 #else
 	else if (strncmp(s,".", strlen(s))==0) /* abbreviatedstep */
-	    xpath_element_new(A_SELF, NULL, &xpnext);
+	    ret = xpath_element_new(A_SELF, NULL, &xpnext);
 #endif
 
 	else if (strncmp(s,"self::", strlen("self::"))==0)
-	    xpath_element_new(A_SELF, s+strlen("self::"), &xpnext);
+	    ret = xpath_element_new(A_SELF, s+strlen("self::"), &xpnext);
 
 	else if (strncmp(s,"parent::", strlen("parent::"))==0)
-	    xpath_element_new(A_PARENT, s+strlen("parent::"), &xpnext);
+	    ret = xpath_element_new(A_PARENT, s+strlen("parent::"), &xpnext);
 	else if (strncmp(s,"ancestor::", strlen("ancestor::"))==0)
-	    xpath_element_new(A_ANCESTOR, s+strlen("ancestor::"), &xpnext);
+	    ret = xpath_element_new(A_ANCESTOR, s+strlen("ancestor::"), &xpnext);
 	else if (strncmp(s,"child::", strlen("child::"))==0)
-	    xpath_element_new(A_CHILD, s+strlen("child::"), &xpnext);
+	    ret = xpath_element_new(A_CHILD, s+strlen("child::"), &xpnext);
 	else 
-	    xpath_element_new(A_CHILD, s, &xpnext);
+	    ret = xpath_element_new(A_CHILD, s, &xpnext);
+	if (ret < 0)
+	    goto done;
 	s += strlen(s) + 1;
     }
     retval = 0;
@@ -393,15 +537,38 @@ xpath_parse(char                  *xpath,
 	free(s0);
     if (retval == 0)
 	*xplist0 = xplist;
+    else if (xplist)
+	xpath_free(xplist);
     return retval;
 }
 
+/*! Check if a node name matches the name test of a step
+ * @param[in]  xe    XPATH step
+ * @param[in]  x     XML node
+ * @retval     1     Match
+ * @retval     0     No match
+ */
+static int
+xpath_name_match(struct xpath_element *xe,
+		 cxobj                *x)
+{
+    switch (xe->xe_match){
+    case XE_EXACT:
+	return xml_name_eq(x, xe->xe_str, xe->xe_iname);
+    case XE_ANY:
+	return 1;
+    case XE_GLOB:
+	break;
+    }
+    return fnmatch(xe->xe_str, xml_name(x), 0) == 0;
+}
+
 /*! Find a node 'deep' in an XML tree
  *
  * The xv_* arguments are filled in  nodes found earlier.
  * args:
  *  @param[in]    xn_parent  Base XML object
- *  @param[in]    name       shell wildcard pattern to match with node name
+ *  @param[in]    xe         XPATH step, its name test is matched with node name
  *  @param[in]    node_type  CX_ELMNT, CX_ATTR or CX_BODY
  *  @param[in,out] vec1      internal buffers with results
  *  @param[in,out] vec0      internal buffers with results
@@ -411,12 +578,12 @@ xpath_parse(char                  *xpath,
  *  0 on OK, -1 on error
  */
 static int
-recursive_find(cxobj   *xn, 
-	       char    *pattern, 
-	       int      node_type,
-	       uint16_t flags,
-	       cxobj ***vec0,
-	       size_t  *vec0len)
+recursive_find(cxobj                *xn, 
+	       struct xpath_element *xe,
+	       int                   node_type,
+	       uint16_t              flags,
+	       cxobj              ***vec0,
+	       size_t               *vec0len)
 {
     int     retval = -1;
     cxobj  *xsub; 
@@ -425,14 +592,14 @@ recursive_find(cxobj   *xn,
 
     xsub = NULL;
     while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
-	if (fnmatch(pattern, xml_name(xsub), 0) == 0){
+	if (xpath_name_match(xe, xsub)){
 	    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xsub, flags));
 	    if (flags==0x0 || xml_flag(xsub, flags))
 		if (cxvec_append(xsub, &vec, &veclen) < 0)
 		    goto done;
 	    //	    continue; /* Dont go deeper */
 	}
-	if (recursive_find(xsub, pattern, node_type, flags, &vec, &veclen) < 0)
+	if (recursive_find(xsub, xe, node_type, flags, &vec, &veclen) < 0)
 	    goto done;
     }
     retval = 0;
@@ -442,14 +609,102 @@ recursive_find(cxobj   *xn,
     return retval;
 }
 
+/*! Check a <name>=<value> predicate on a single node
+ * @param[in]  xv   XML node
+ * @param[in]  xp   Predicate of type XP_EQ
+ * @retval     1    Some child element <name> of xv has body <value>
+ * @retval     0    No match
+ * @see xpath_expr  which checks a vector of nodes
+ */
+static int
+xpath_pred_eq(cxobj                  *xv,
+	      struct xpath_predicate *xp)
+{
+    cxobj *x = NULL;
+    char  *val;
+
+    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+	if (strcmp(xp->xp_name, xml_name(x)) != 0)
+	    continue;
+	if ((val = xml_body(x)) != NULL &&
+	    strcmp(val, xp->xp_value) == 0)
+	    return 1;
+    }
+    return 0;
+}
+
+/*! Find child of xv matching a child step with a key predicate, eg a[k=v]
+ * Possible if the children named a are entries of a yang list with the single
+ * key k. Then the key index of xv is used instead of checking all children.
+ * @param[in]     xv      XML node whose children are searched
+ * @param[in]     xe      XPATH child step with exact name and XP_EQ predicate
+ * @param[in]     flags   if != 0, only match xml nodes matching flags
+ * @param[in,out] vec     Matching child (if any) is appended here
+ * @param[in,out] veclen  Length of vec
+ * @retval        1       Done, the predicate is checked
+ * @retval        0       Not a keyed list, nothing done
+ * @retval       -1       Error
+ * @see xml_find_keyed
+ */
+static int
+xpath_child_keyed(cxobj                *xv,
+		  struct xpath_element *xe,
+		  uint16_t              flags,
+		  cxobj              ***vec,
+		  size_t               *veclen)
+{
+    int                     retval = -1;
+    struct xpath_predicate *xp = xe->xe_predicate;
+    cxobj                  *xc;
+    cxobj                  *x1 = NULL;
+    cxobj                  *xb;
+    yang_stmt              *y;
+    cvec                   *cvk;
+
+    if ((xc = xml_find(xv, xe->xe_str)) == NULL ||
+	xml_type(xc) != CX_ELMNT ||
+	(y = xml_spec(xc)) == NULL ||
+	y->ys_keyword != Y_LIST ||
+	yang_find((yang_node*)y, Y_KEY, NULL) == NULL){
+	retval = 0;
+	goto done;
+    }
+    if ((cvk = yang_key_cvec(y)) == NULL)
+	goto done;
+    if (cvec_len(cvk) != 1 ||
+	strcmp(cv_string_get(cvec_i(cvk, 0)), xp->xp_name) != 0){
+	retval = 0;
+	goto done;
+    }
+    /* Make an entry with the key value to look up */
+    if ((x1 = xml_new(xe->xe_str, NULL)) == NULL ||
+	(xb = xml_new(xp->xp_name, x1)) == NULL ||
+	(xb = xml_new("body", xb)) == NULL)
+	goto done;
+    xml_type_set(xb, CX_BODY);
+    if (xml_value_set(xb, xp->xp_value) < 0)
+	goto done;
+    if (xml_find_keyed(xv, x1, y, &xc) < 0)
+	goto done;
+    if (xc && (flags==0x0 || xml_flag(xc, flags)))
+	if (cxvec_append(xc, vec, veclen) < 0)
+	    goto done;
+    retval = 1;
+ done:
+    if (x1)
+	xml_free(x1);
+    return retval;
+}
+
 /* forward */
 static int
-xpath_exec(cxobj *xcur, char *xpath, cxobj **vec0, size_t vec0len,
-	   uint16_t flags, cxobj ***vec2, size_t *vec2len);
+xpath_find(cxobj *xcur, struct xpath_element *xe, int descendants0,
+	   cxobj **vec0, size_t vec0len, uint16_t flags,
+	   cxobj ***vec2, size_t *vec2len);
 
 /*! XPath predicate expression check
- * @param[in]  xcur  xml-tree where to search
- * @param[in]     predicate_expression     xpath expression as a string
+ * @param[in]     xcur    xml-tree where to search
+ * @param[in]     xp      Predicate expression, compiled by xpath_predicate_compile
  * @param[in]     flags   Extra xml flag checks that must match (apart from predicate)
  * @param[in,out] vec0    Vector or xml nodes that are checked. Not matched are filtered
  * @param[in,out] vec0len Length of vector or matches
@@ -463,14 +718,12 @@ xpath_exec(cxobj *xcur, char *xpath, cxobj **vec0, size_t vec0len,
  * @see https://www.w3.org/TR/xpath/#predicates
  */
 static int
-xpath_expr(cxobj    *xcur, 
-	   char     *predicate_expression, 	   
-	   uint16_t  flags,
-	   cxobj  ***vec0,
-	   size_t   *vec0len)
+xpath_expr(cxobj                  *xcur, 
+	   struct xpath_predicate *xp,
+	   uint16_t                flags,
+	   cxobj                ***vec0,
+	   size_t                 *vec0len)
 {
-    char      *e_a;
-    char      *e_v;
     int        i;
     int        j;
     int        retval = -1;
@@ -478,31 +731,20 @@ xpath_expr(cxobj    *xcur,
     cxobj     *xv;
     cxobj    **vec = NULL;
     size_t     veclen = 0;
-    int        oplen;
-    char      *tag;
     char      *val;
-    char      *e0;
-    char      *e;
-
-    if ((e0 = strdup(predicate_expression)) == NULL){
-	clicon_err(OE_UNIX, errno, "strdup");
-	goto done;
-    }
-    e = e0;
-    if (*e == '@'){ /* @ attribute */
-	e++;
-	e_v=e;
-	e_a = strsep(&e_v, "=");
-	if (e_a == NULL){
-	    clicon_err(OE_XML, errno, "%s: malformed expression: [@%s]", 
-		       __FUNCTION__, e);
-	    goto done;
-	}
+    cxobj    **svec0 = NULL;
+    size_t     svec0len = 0;
+    cxobj    **svec1 = NULL;
+    size_t     svec1len = 0;
+    char      *ebody;
+
+    switch (xp->xp_type){
+    case XP_ATTR:
 	for (i=0; i<*vec0len; i++){
 	    xv = (*vec0)[i];
-	    if ((x = xml_find(xv, e_a)) != NULL &&
+	    if ((x = xml_find(xv, xp->xp_name)) != NULL &&
 		(xml_type(x) == CX_ATTR)){
-		if (!e_v || strcmp(xml_value(x), e_v) == 0){
+		if (!xp->xp_value || strcmp(xml_value(x), xp->xp_value) == 0){
 		    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
 		    if (flags==0x0 || xml_flag(xv, flags)){
 			if (cxvec_append(xv, &vec, &veclen) < 0)
@@ -512,104 +754,127 @@ xpath_expr(cxobj    *xcur,
 		}
 	    }
 	}
-    }
-    else{ /* either <n> or <tag><op><value>, where <op>='=' for now */
-	oplen = strcspn(e, "=");
-	if (strlen(e+oplen)==0){ /* no operator */
-	    if (sscanf(e, "%d", &i) == 1){ /* number */
-		if (i < *vec0len){
-		    xv = (*vec0)[i]; /* XXX: cant compress: gcc breaks */
+	break;
+    case XP_INDEX:
+	i = xp->xp_index;
+	if (i < *vec0len){
+	    xv = (*vec0)[i]; /* XXX: cant compress: gcc breaks */
 	    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
-		    if (flags==0x0 || xml_flag(xv, flags))
-			if (cxvec_append(xv, &vec, &veclen) < 0)
-			    goto done;
-		}
-	    }
-	    else{
-		clicon_err(OE_XML, errno, "%s: malformed expression: [%s]", 
-			   __FUNCTION__, e);
-		goto done;
-	    }
-	}
-	else{ /* name = expr */
-	    if ((tag = strsep(&e, "=")) == NULL){
-		clicon_err(OE_XML, errno, "%s: malformed expression: [%s]", 
-			   __FUNCTION__, e);
-		goto done;
-	    }
-	    /* Strip trailing spaces */
-	    while (tag[strlen(tag)-1] == ' ')
-		tag[strlen(tag)-1] = '\0';
-	    /* Strip heading spaces */
-	    while (e[0]==' ')
-		e++;
-	    if (strncmp(e, "current()", strlen("current()")) == 0){
-		/* name = current()xpath */
-		cxobj    **svec0 = NULL;
-		size_t     svec0len = 0;
-		cxobj    **svec1 = NULL;
-		size_t     svec1len = 0;
-		char      *ebody;
-
-		e += strlen("current("); /* e is path expression */
-		*e = '.';
-		if ((svec0 = calloc(1, sizeof(cxobj *))) == NULL){
-		    clicon_err(OE_UNIX, errno, "calloc");
-		    goto done;
-		}
-		svec0[0] = xcur;
-		svec0len++;
-		/* Recursive invocation */
-		if (xpath_exec(xcur, e, svec0, svec0len,
-			       flags, &svec1, &svec1len) < 0)
+	    if (flags==0x0 || xml_flag(xv, flags))
+		if (cxvec_append(xv, &vec, &veclen) < 0)
 		    goto done;
-		for (j=0; j<svec1len; j++){
-		    ebody = xml_body(svec1[j]);
-		    for (i=0; i<*vec0len; i++){
-			xv = (*vec0)[i];
-			x = NULL;
-			while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
-			    if (strcmp(tag, xml_name(x)) != 0)
-				continue;
-			    if ((val = xml_body(x)) != NULL &&
-				strcmp(val, ebody) == 0){	
-				clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
-				if (flags==0x0 || xml_flag(xv, flags))
-				    if (cxvec_append(xv, &vec, &veclen) < 0)
-					goto done;
-			    }
-			}
+	}
+	break;
+    case XP_CURRENT: /* name = current()xpath */
+	if (cxvec_append(xcur, &svec0, &svec0len) < 0)
+	    goto done;
+	/* Recursive invocation, svec0 is consumed */
+	if (xpath_find(xcur, xp->xp_path, 0, svec0, svec0len,
+		       flags, &svec1, &svec1len) < 0)
+	    goto done;
+	for (j=0; j<svec1len; j++){
+	    ebody = xml_body(svec1[j]);
+	    for (i=0; i<*vec0len; i++){
+		xv = (*vec0)[i];
+		x = NULL;
+		while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+		    if (strcmp(xp->xp_name, xml_name(x)) != 0)
+			continue;
+		    if ((val = xml_body(x)) != NULL && ebody &&
+			strcmp(val, ebody) == 0){	
+			clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
+			if (flags==0x0 || xml_flag(xv, flags))
+			    if (cxvec_append(xv, &vec, &veclen) < 0)
+				goto done;
 		    }
 		}
 	    }
-	    else { /* name = value */
-		for (i=0; i<*vec0len; i++){
-		    xv = (*vec0)[i];
-		    /* Check if more may match,... */
-		    x = NULL;
-		    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
-			if (strcmp(tag, xml_name(x)) != 0)
-			    continue;
-			if ((val = xml_body(x)) != NULL &&
-			    strcmp(val, e) == 0){
-			    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
-			    if (flags==0x0 || xml_flag(xv, flags))
-				if (cxvec_append(xv, &vec, &veclen) < 0)
-				    goto done;
-			}
-		    }
+	}
+	break;
+    case XP_EQ: /* name = value */
+	for (i=0; i<*vec0len; i++){
+	    xv = (*vec0)[i];
+	    /* Check if more may match,... */
+	    x = NULL;
+	    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+		if (strcmp(xp->xp_name, xml_name(x)) != 0)
+		    continue;
+		if ((val = xml_body(x)) != NULL &&
+		    strcmp(val, xp->xp_value) == 0){
+		    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xv, flags));
+		    if (flags==0x0 || xml_flag(xv, flags))
+			if (cxvec_append(xv, &vec, &veclen) < 0)
+			    goto done;
 		}
 	    }
 	}
+	break;
     }
     /* copy the array from 1 to 0 */
     free(*vec0);
     *vec0 = vec;
     *vec0len = veclen;
+    vec = NULL;
     retval = 0;
   done:
-    if (e0)
-	free(e0);
+    if (vec)
+	free(vec);
+    if (svec1)
+	free(svec1);
+    return retval;
+}
+
+/*! Remove duplicate nodes from an xml vector, keeping the first occurrence
+ * Short vectors are checked pairwise, longer with a hash set of node pointers,
+ * so that removing duplicates from a vector of length n is O(n).
+ * @param[in,out] vec     Vector of xml nodes, order is kept
+ * @param[in,out] veclen  Length of vector
+ */
+static int
+xpath_vec_unique(cxobj  **vec,
+		 size_t  *veclen)
+{
+    int        retval = -1;
+    cxobj    **set = NULL;
+    size_t     size;
+    size_t     i;
+    size_t     j;
+    size_t     k;
+    size_t     len = 0;
+    uintptr_t  h;
+
+    if (*veclen < XPATH_UNIQUE_MIN){
+	for (i=0; i<*veclen; i++){
+	    for (j=0; j<len; j++)
+		if (vec[j] == vec[i])
+		    break;
+	    if (j == len)
+		vec[len++] = vec[i];
+	}
+    }
+    else{
+	for (size = XPATH_UNIQUE_MIN; size < 2*(*veclen); size *= 2);
+	if ((set = calloc(size, sizeof(cxobj *))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	for (i=0; i<*veclen; i++){
+	    h = (uintptr_t)vec[i];
+	    h ^= h >> 17;
+	    for (k = (h >> 4) & (size-1); set[k] != NULL; k = (k+1) & (size-1))
+		if (set[k] == vec[i])
+		    break;
+	    if (set[k] == NULL){ /* new */
+		set[k] = vec[i];
+		vec[len++] = vec[i];
+	    }
+	}
+    }
+    *veclen = len;
+    retval = 0;
+ done:
+    if (set)
+	free(set);
     return retval;
 }
 
@@ -644,6 +909,10 @@ xpath_find(cxobj                *xcur,
     cxobj         *xparent;
     size_t         vec1len = 0;
     struct xpath_predicate *xp;
+    struct xpath_predicate *xp0; /* First predicate not yet checked */
+    int            ret;
+    cxobj        **dvec;
+    size_t         dveclen;
 
     if (xe == NULL){
 	/* append */
@@ -660,6 +929,7 @@ xpath_find(cxobj                *xcur,
     fprintf(stderr, "%s: %s: \"%s\"\n", __FUNCTION__, 
 	    clicon_int2str(axismap, xe->xe_type), xe->xe_str?xe->xe_str:"");
 #endif
+    xp0 = xe->xe_predicate;
     switch (xe->xe_type){
     case A_SELF:
 	break;
@@ -689,16 +959,45 @@ xpath_find(cxobj                *xcur,
 	if (descendants0){
 	    for (i=0; i<vec0len; i++){
 		xv = vec0[i];
-		if (recursive_find(xv, xe->xe_str, CX_ELMNT, flags, &vec1, &vec1len) < 0)
+		if (xe->xe_match == XE_EXACT && xml_parent(xv) == NULL){
+		    /* Eg //name: use descendant index of tree */
+		    if (xml_find_descendants(xv, xe->xe_str, &dvec, &dveclen) < 0)
+			goto done;
+		    for (j=0; j<dveclen; j++)
+			if (flags==0x0 || xml_flag(dvec[j], flags))
+			    if (cxvec_append(dvec[j], &vec1, &vec1len) < 0)
+				goto done;
+		}
+		else if (recursive_find(xv, xe, CX_ELMNT, flags, &vec1, &vec1len) < 0)
+		    goto done;
+	    }
+	}
+	else if (xe->xe_match == XE_EXACT && xp0 && xp0->xp_type == XP_EQ){
+	    /* Eg a[k=v]: check the first predicate already here, using
+	     * the key index if a is a list with key k */
+	    for (i=0; i<vec0len; i++){
+		xv = vec0[i];
+		if ((ret = xpath_child_keyed(xv, xe, flags, &vec1, &vec1len)) < 0)
 		    goto done;
+		if (ret == 1)
+		    continue;
+		x = NULL;
+		while ((x = xml_child_each(xv, x, -1)) != NULL) {
+		    if (xml_name_eq(x, xe->xe_str, xe->xe_iname) &&
+			xpath_pred_eq(x, xp0) &&
+			(flags==0x0 || xml_flag(x, flags)))
+			if (cxvec_append(x, &vec1, &vec1len) < 0)
+			    goto done;
+		}
 	    }
+	    xp0 = xp0->xp_next;
 	}
 	else
 	    for (i=0; i<vec0len; i++){
 		xv = vec0[i];
 		x = NULL;
 		while ((x = xml_child_each(xv, x, -1)) != NULL) {
-		    if (fnmatch(xe->xe_str, xml_name(x), 0) == 0){ 
+		    if (xpath_name_match(xe, x)){ 
 	    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(x, flags));
 			if (flags==0x0 || xml_flag(x, flags))
 			    if (cxvec_append(x, &vec1, &vec1len) < 0)
@@ -718,18 +1017,11 @@ xpath_find(cxobj                *xcur,
     default:
 	break;
     }
-    /* remove duplicates */
-    for (i=0; i<vec0len; i++){
-	for (j=i+1; j<vec0len; j++){
-	    if (vec0[i] == vec0[j]){
-		memmove(vec0[j], vec0[j+1], (vec0len-j)*sizeof(cxobj*));
-	        vec0len--;
-	    }
-	}
-    }
+    if (xpath_vec_unique(vec0, &vec0len) < 0)
+	goto done;
 
-    for (xp = xe->xe_predicate; xp; xp = xp->xp_next){
-	if (xpath_expr(xcur, xp->xp_expr, flags, &vec0, &vec0len) < 0)
+    for (xp = xp0; xp; xp = xp->xp_next){
+	if (xpath_expr(xcur, xp, flags, &vec0, &vec0len) < 0)
 	    goto done;
     }
     if (xpath_find(xcur, xe->xe_next, descendants, 
@@ -778,42 +1070,177 @@ xpath_split(char  *xpathstr,
     return retval;
 }
 
-/*! Process single xpath expression on xml tree
- * @param[in]  xcur  xml-tree where to search
- * @param[in]  xpath   string with XPATH syntax
- * @param[in]  vec0    vector of XML trees
- * @param[in]  vec0len length of XML trees
- * @param[in]  flags   if != 0, only match xml nodes matching flags
- * @param[out] vec2    Result XML node vector
- * @param[out] vec2len Length of result vector.
+/*! Compile an xpath expression for repeated evaluation
+ * The xpath is parsed once into steps and predicates, which can then be 
+ * evaluated on any xml tree with xpath_vec_compiled() without re-parsing.
+ * Alternatives separated with " | " are compiled into the same handle.
+ * @param[in]  xpath   String with XPATH syntax
+ * @retval     xc      Compiled xpath. Free with xpath_comp_free()
+ * @retval     NULL    Error
+ * @code
+ *   xpath_comp *xc;
+ *   if ((xc = xpath_compile("//symbol/foo")) == NULL)
+ *      goto err;
+ *   if (xpath_vec_compiled(xcur, xc, 0, &vec, &veclen) < 0)
+ *      goto err;
+ *   ...
+ *   xpath_comp_free(xc);
+ * @endcode
+ * @see xpath_vec_compiled
  */
-static int
-xpath_exec(cxobj        *xcur, 
-	   char         *xpath, 
-	   cxobj       **vec0, 
-	   size_t        vec0len,
-	   uint16_t      flags,
-	   cxobj      ***vec2, 
-	   size_t       *vec2len)
+xpath_comp *
+xpath_compile(char *xpath)
 {
-    struct xpath_element *xplist;
-    cxobj               **vec1;
-    size_t                vec1len;
+    xpath_comp            *xc = NULL;
+    struct xpath_element **vec;
+    char                  *s0 = NULL;
+    char                  *s1;
+    char                  *s2;
 
-    if (cxvec_dup(vec0, vec0len, &vec1, &vec1len) < 0)
-	goto done;
-    if (xpath_parse(xpath, &xplist) < 0)
-	goto done;
-    if (debug > 1)
-	xpath_print(stderr, xplist);
-    if (xpath_find(xcur, xplist, 0, vec1, vec1len, flags, vec2, vec2len) < 0)
-	goto done;
-    if (xpath_free(xplist) < 0)
-	goto done;
-  done:
+    if ((xc = malloc(sizeof(*xc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto err;
+    }
+    memset(xc, 0, sizeof(*xc));
+    if ((s0 = strdup(xpath)) == NULL){
+	clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
+	goto err;
+    }
+    s1 = s0;
+    while (s1 != NULL){
+	if ((s2 = strstr(s1, " | ")) != NULL){
+	    *s2 = '\0'; /* terminate xpath */
+	    s2 += 3;
+	}
+	if ((vec = realloc(xc->xc_vec, (xc->xc_len+1)*sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    goto err;
+	}
+	xc->xc_vec = vec;
+	if (xpath_parse(s1, &xc->xc_vec[xc->xc_len]) < 0)
+	    goto err;
+	xc->xc_len++;
+	if (debug > 1)
+	    xpath_print(stderr, xc->xc_vec[xc->xc_len-1]);
+	s1 = s2;
+    }
+    free(s0);
+    return xc;
+ err:
+    if (s0)
+	free(s0);
+    if (xc)
+	xpath_comp_free(xc);
+    return NULL;
+}
+
+/*! Free a compiled xpath
+ * @param[in]  xc   Compiled xpath, created by xpath_compile()
+ */
+int
+xpath_comp_free(xpath_comp *xc)
+{
+    int i;
+
+    for (i=0; i<xc->xc_len; i++)
+	xpath_free(xc->xc_vec[i]);
+    if (xc->xc_vec)
+	free(xc->xc_vec);
+    free(xc);
     return 0;
-} /* xpath_exec */
+}
 
+/*! Get a compiled xpath from the cache, or compile and add it to the cache
+ * The cache has at most XPATH_CACHE_MAX entries. When full, the least 
+ * recently used entry is removed.
+ * @param[in]  xpath   String with XPATH syntax
+ * @retval     xc      Compiled xpath. Owned by the cache, do not free
+ * @retval     NULL    Error
+ */
+static xpath_comp *
+xpath_cache_get(char *xpath)
+{
+    struct xpath_cache **xyp;
+    struct xpath_cache  *xy;
+
+    if (xpath_cache_hash == NULL &&
+	(xpath_cache_hash = hash_init()) == NULL)
+	return NULL;
+    if ((xyp = hash_value(xpath_cache_hash, xpath, NULL)) != NULL){
+	xy = *xyp;
+	if (xy != xpath_cache_list){ /* Move first in LRU list */
+	    DELQ(xy, xpath_cache_list, struct xpath_cache *);
+	    INSQ(xy, xpath_cache_list);
+	}
+	return xy->xy_xc;
+    }
+    if (xpath_cache_len >= XPATH_CACHE_MAX){ /* Remove least recently used */
+	xy = (struct xpath_cache *)xpath_cache_list->xy_qelem.q_prev;
+	DELQ(xy, xpath_cache_list, struct xpath_cache *);
+	hash_del(xpath_cache_hash, xy->xy_str);
+	xpath_comp_free(xy->xy_xc);
+	free(xy->xy_str);
+	free(xy);
+	xpath_cache_len--;
+    }
+    if ((xy = malloc(sizeof(*xy))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(xy, 0, sizeof(*xy));
+    if ((xy->xy_str = strdup(xpath)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(xy);
+	return NULL;
+    }
+    if ((xy->xy_xc = xpath_compile(xpath)) == NULL ||
+	hash_add(xpath_cache_hash, xpath, &xy, sizeof(xy)) == NULL){
+	if (xy->xy_xc)
+	    xpath_comp_free(xy->xy_xc);
+	free(xy->xy_str);
+	free(xy);
+	return NULL;
+    }
+    INSQ(xy, xpath_cache_list);
+    xpath_cache_len++;
+    return xy->xy_xc;
+}
+
+/*! Evaluate compiled xpath on xml tree and append matches to a vector
+ * @param[in]     xcur    xml-tree where to search
+ * @param[in]     xc      Compiled xpath
+ * @param[in]     flags   if != 0, only match xml nodes matching flags
+ * @param[in,out] vec1    Result XML node vector, matches are appended
+ * @param[in,out] vec1len Length of result vector.
+ * Note: if a match is found in several alternatives, two (or more) same 
+ * results will be returned.
+ */
+static int
+xpath_exec(cxobj      *xcur, 
+	   xpath_comp *xc,
+	   uint16_t    flags,
+	   cxobj    ***vec1, 
+	   size_t     *vec1len)
+{
+    int     retval = -1;
+    int     i;
+    cxobj **vec0;
+    size_t  vec0len;
+
+    for (i=0; i<xc->xc_len; i++){
+	vec0 = NULL;
+	vec0len = 0;
+	if (cxvec_append(xcur, &vec0, &vec0len) < 0)
+	    goto done;
+	/* vec0 is consumed by xpath_find */
+	if (xpath_find(xcur, xc->xc_vec[i], 0, vec0, vec0len, flags, 
+		       vec1, vec1len) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
 
 /*! Intermediate xpath function to handle 'conditional' cases. 
  * @param[in]  xcur  xml-tree where to search
@@ -822,11 +1249,10 @@ xpath_exec(cxobj        *xcur,
  * @param[in]  vec1    vector of XML trees
  * @param[in]  vec1len length of XML trees
  * For example: xpath = //a | //b. 
- * xpath_first+ splits xpath up in several subcalls
- * (eg xpath=//a and xpath=//b) and collects the results.
+ * The xpath is compiled (or found in the cache) into alternatives
+ * (eg xpath=//a and xpath=//b) and the results are collected.
  * Note: if a match is found in both, two (or more) same results will be 
  * returned.
- * Note, this could be 'folded' into xpath1 but I judged it too complex.
  */
 static int
 xpath_choice(cxobj   *xcur, 
@@ -835,42 +1261,15 @@ xpath_choice(cxobj   *xcur,
 	     cxobj ***vec1, 
 	     size_t  *vec1len)
 {
-    int               retval = -1;
-    char             *s0;
-    char             *s1;
-    char             *s2;
-    char             *xpath;
-    cxobj           **vec0 = NULL;
-    size_t            vec0len = 0;
-
-    if ((s0 = strdup(xpath0)) == NULL){
-	clicon_err(OE_XML, errno, "%s: strdup", __FUNCTION__);
+    int         retval = -1;
+    xpath_comp *xc;
+
+    if ((xc = xpath_cache_get(xpath0)) == NULL)
 	goto done;
-    }
-    s2 = s1 = s0;
-    if ((vec0 = calloc(1, sizeof(cxobj *))) == NULL){
-	clicon_err(OE_UNIX, errno, "calloc");
+    if (xpath_exec(xcur, xc, flags, vec1, vec1len) < 0)
 	goto done;
-    }
-    vec0[0] = xcur;
-    vec0len++;
-    while (s1 != NULL){
-	s2 = strstr(s1, " | ");
-	if (s2 != NULL){
-	    *s2 = '\0'; /* terminate xpath */
-	    s2 += 3;
-	}
-	xpath = s1;
-	s1 = s2;
-	if (xpath_exec(xcur, xpath, vec0, vec0len, flags, vec1, vec1len) < 0)
-	    goto done;
-    }
     retval = 0;
   done:
-    if (s0)
-	free(s0);
-    if (vec0)
-	free(vec0);
     return retval;
 }
 
@@ -1126,6 +1525,29 @@ xpath_vec_flag(cxobj   *xcur,
     return retval;
 }
 
+/*! Evaluate a compiled xpath and return a vector of matches
+ * @param[in]  xcur    xml-tree where to search
+ * @param[in]  xc      Compiled xpath, created by xpath_compile()
+ * @param[in]  flags   Set of flags that return nodes must match (0 if all)
+ * @param[out] vec     vector of xml-trees. Vector must be free():d after use
+ * @param[out] veclen  returns length of vector in return value
+ * @retval     0       OK
+ * @retval     -1      error.
+ * @see xpath_compile
+ * @see xpath_vec_flag  Same, but the xpath is given as string
+ */
+int
+xpath_vec_compiled(cxobj      *xcur, 
+		   xpath_comp *xc,
+		   uint16_t    flags,
+		   cxobj    ***vec, 
+		   size_t     *veclen)
+{
+    *vec = NULL;
+    *veclen = 0;
+    return xpath_exec(xcur, xc, flags, vec, veclen);
+}
+
 /*
  * Turn this on to get an xpath test program 
  * Usage: xpath [<xpath>] 
@@ -71,6 +71,29 @@
 #include "clixon_yang_type.h"
 #include "clixon_yang_parse.h"
 
+/*
+ * Constants
+ */
+#define YANG_INDEX_MIN 4 /* Do not index yang nodes with fewer children */
+
+/*
+ * Types
+ */
+
+/*! Name index of the children of a yang node
+ * Open-addressed hash tables of child statements. Keys are taken from the
+ * statements themselves. Only the first statement of each key is entered,
+ * so that lookups return the same statement as a linear search.
+ * For yang specs, yx_data and yx_schema are the top nodes of all modules.
+ * @see yang_find, yang_find_datanode, yang_find_schemanode, yang_find_topnode
+ */
+struct yang_index{
+    uint32_t    yx_size;   /* Nr of slots in each table, power of 2 */
+    yang_stmt **yx_stmt;   /* (keyword, argument) -> child */
+    yang_stmt **yx_data;   /* argument -> data node, choice/case flattened */
+    yang_stmt **yx_schema; /* argument -> schema node, choice/case flattened */
+};
+
 
 /* Mapping between yang keyword string <--> clicon constants */
 static const map_str2int ykmap[] = {
@@ -186,11 +209,374 @@ ys_new(enum rfc_6020 keyw)
     return ys;
 }
 
+/*! Hash a yang keyword and argument to a yang index slot */
+static uint32_t
+yang_index_hash(int   keyword, 
+		char *argument)
+{
+    uint32_t h = 2166136261u ^ (uint32_t)keyword; /* FNV-1a */
+
+    while (*argument){
+	h ^= (uint8_t)*argument++;
+	h *= 16777619u;
+    }
+    return h;
+}
+
+/*! Find statement in yang index table
+ * @param[in]  tab       Hash table
+ * @param[in]  size      Nr of slots, power of 2
+ * @param[in]  keyword   Match also keyword, or 0 if table is keyed only on argument
+ * @param[in]  argument  Argument string
+ */
+static yang_stmt *
+yang_index_lookup(yang_stmt **tab, 
+		  uint32_t    size,
+		  int         keyword,
+		  char       *argument)
+{
+    yang_stmt *ys;
+    uint32_t   i;
+
+    i = yang_index_hash(keyword, argument) & (size-1);
+    while ((ys = tab[i]) != NULL){
+	if ((keyword == 0 || ys->ys_keyword == keyword) &&
+	    strcmp(argument, ys->ys_argument) == 0)
+	    return ys;
+	i = (i+1) & (size-1);
+    }
+    return NULL;
+}
+
+/*! Add statement to yang index table, unless a statement with same key exists
+ * @see yang_index_lookup
+ */
+static void
+yang_index_add(yang_stmt **tab, 
+	       uint32_t    size,
+	       int         keyword,
+	       yang_stmt  *ys)
+{
+    yang_stmt *yi;
+    uint32_t   i;
+
+    if (ys->ys_argument == NULL)
+	return;
+    i = yang_index_hash(keyword, ys->ys_argument) & (size-1);
+    while ((yi = tab[i]) != NULL){
+	if ((keyword == 0 || yi->ys_keyword == keyword) &&
+	    strcmp(ys->ys_argument, yi->ys_argument) == 0)
+	    return; /* first wins */
+	i = (i+1) & (size-1);
+    }
+    tab[i] = ys;
+}
+
+/*! Free a yang index */
+static int
+yang_index_free(yang_index *yx)
+{
+    if (yx->yx_stmt)
+	free(yx->yx_stmt);
+    if (yx->yx_data)
+	free(yx->yx_data);
+    if (yx->yx_schema)
+	free(yx->yx_schema);
+    free(yx);
+    return 0;
+}
+
+/*! Free data node tables of a yang node */
+static int
+yang_datatab_free(yang_datatab *yt)
+{
+    int i;
+
+    if (yt->yt_defbody){
+	for (i=0; i<yt->yt_deflen; i++)
+	    if (yt->yt_defbody[i])
+		free(yt->yt_defbody[i]);
+	free(yt->yt_defbody);
+    }
+    if (yt->yt_defleaf)
+	free(yt->yt_defleaf);
+    if (yt->yt_defidx)
+	free(yt->yt_defidx);
+    free(yt);
+    return 0;
+}
+
+/*! Remove index of a yang node since its children are changed
+ * Indexes of ancestors are also removed since they may contain the children 
+ * (choice/case flattening and yang spec top nodes). Lookups then use linear
+ * search. Data node tables are removed in the same way and rebuilt on demand.
+ */
+static void
+yang_index_drop(yang_node *yn)
+{
+    yang_stmt *ys;
+
+    for (; yn; yn = yn->yn_parent){
+	if (yn->yn_index){
+	    yang_index_free(yn->yn_index);
+	    yn->yn_index = NULL;
+	}
+	if (yn->yn_keyword != Y_SPEC){
+	    ys = (yang_stmt*)yn;
+	    if (ys->ys_datatab){
+		yang_datatab_free(ys->ys_datatab);
+		ys->ys_datatab = NULL;
+	    }
+	}
+    }
+}
+
+/*! Add data or schema nodes of a yang node to index table, flatten choice/case
+ * Same traversal order as yang_find_datanode and yang_find_schemanode
+ * @param[in]  yn      Yang node
+ * @param[in]  tab     Hash table, or NULL to only count
+ * @param[in]  size    Nr of slots in tab
+ * @param[in]  schema  If set add schema nodes, otherwise data nodes
+ * @retval     n       Nr of nodes traversed
+ */
+static int
+yang_index_flatten(yang_node  *yn, 
+		   yang_stmt **tab,
+		   uint32_t    size,
+		   int         schema)
+{
+    yang_stmt *ys;
+    yang_stmt *yc;
+    int        i, j;
+    int        n = 0;
+
+    for (i=0; i<yn->yn_len; i++){
+	ys = yn->yn_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE) /* Look for its children */
+		    n += yang_index_flatten((yang_node*)yc, tab, size, schema);
+		else if (schema ? yang_schemanode(yc) : yang_datanode(yc)){
+		    if (tab)
+			yang_index_add(tab, size, 0, yc);
+		    n++;
+		}
+	    }
+	}
+	else if (schema ? yang_schemanode(ys) : yang_datanode(ys)){
+	    if (tab)
+		yang_index_add(tab, size, 0, ys);
+	    n++;
+	}
+    }
+    return n;
+}
+
+/*! Build name index of the children of a yang node 
+ * @param[in]  yn  Yang node or yang spec
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+yang_index_build(yang_node *yn)
+{
+    int         retval = -1;
+    yang_index *yx = NULL;
+    int         n;
+    int         i;
+    uint32_t    size;
+
+    if (yn->yn_index){
+	yang_index_free(yn->yn_index);
+	yn->yn_index = NULL;
+    }
+    n = yn->yn_len;
+    if (yn->yn_keyword == Y_SPEC) /* top nodes of all modules */
+	for (i=0; i<yn->yn_len; i++)
+	    n += yang_index_flatten((yang_node*)yn->yn_stmt[i], NULL, 0, 1);
+    else
+	n += yang_index_flatten(yn, NULL, 0, 1);
+    if (n < YANG_INDEX_MIN)
+	goto ok;
+    for (size = 8; size < 2*n; size *= 2);
+    if ((yx = malloc(sizeof(*yx))) == NULL){
+	clicon_err(OE_YANG, errno, "%s: malloc", __FUNCTION__);
+	goto done;
+    }
+    memset(yx, 0, sizeof(*yx));
+    yx->yx_size = size;
+    if ((yx->yx_stmt = calloc(size, sizeof(yang_stmt *))) == NULL ||
+	(yx->yx_data = calloc(size, sizeof(yang_stmt *))) == NULL ||
+	(yx->yx_schema = calloc(size, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_YANG, errno, "%s: calloc", __FUNCTION__);
+	goto done;
+    }
+    for (i=0; i<yn->yn_len; i++)
+	yang_index_add(yx->yx_stmt, size, yn->yn_stmt[i]->ys_keyword, yn->yn_stmt[i]);
+    if (yn->yn_keyword == Y_SPEC)
+	for (i=0; i<yn->yn_len; i++){
+	    yang_index_flatten((yang_node*)yn->yn_stmt[i], yx->yx_data, size, 0);
+	    yang_index_flatten((yang_node*)yn->yn_stmt[i], yx->yx_schema, size, 1);
+	}
+    else{
+	yang_index_flatten(yn, yx->yx_data, size, 0);
+	yang_index_flatten(yn, yx->yx_schema, size, 1);
+    }
+    yn->yn_index = yx;
+    yx = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (yx)
+	yang_index_free(yx);
+    return retval;
+}
+
+/*! Set positions of data node children, flatten choice/case
+ * Same traversal order as yang_index_flatten
+ * @param[in]  yn  Yang node
+ * @param[in]  n   Position of first data node
+ * @retval     n   Position after last data node
+ */
+static int
+yang_datatab_order(yang_node *yn, 
+		   int        n)
+{
+    yang_stmt *ys;
+    yang_stmt *yc;
+    int        i, j;
+
+    for (i=0; i<yn->yn_len; i++){
+	ys = yn->yn_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE) /* Look for its children */
+		    n = yang_datatab_order((yang_node*)yc, n);
+		else if (yang_datanode(yc))
+		    yc->ys_order = n++;
+	    }
+	}
+	else if (yang_datanode(ys))
+	    ys->ys_order = n++;
+    }
+    return n;
+}
+
+/*! Build data node tables of a yang node
+ * Set the position of each data node child, and for containers and lists,
+ * collect leaf children with default values and their values as strings.
+ * @param[in]  ys  Yang statement
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+yang_datatab_build(yang_stmt *ys)
+{
+    int           retval = -1;
+    yang_datatab *yt = NULL;
+    yang_stmt    *yc;
+    int           i;
+    int           n;
+
+    if ((yt = malloc(sizeof(*yt))) == NULL){
+	clicon_err(OE_YANG, errno, "%s: malloc", __FUNCTION__);
+	goto done;
+    }
+    memset(yt, 0, sizeof(*yt));
+    yt->yt_len = yang_datatab_order((yang_node*)ys, 0);
+    if (ys->ys_keyword == Y_CONTAINER || ys->ys_keyword == Y_LIST){
+	n = 0;
+	for (i=0; i<ys->ys_len; i++){
+	    yc = ys->ys_stmt[i];
+	    if (yc->ys_keyword == Y_LEAF && yc->ys_cv && 
+		!cv_flag(yc->ys_cv, V_UNSET)) /* Default value exists */
+		n++;
+	}
+	if (n){
+	    if ((yt->yt_defleaf = calloc(n, sizeof(yang_stmt *))) == NULL ||
+		(yt->yt_defbody = calloc(n, sizeof(char *))) == NULL ||
+		(yt->yt_defidx = malloc(yt->yt_len*sizeof(int))) == NULL){
+		clicon_err(OE_YANG, errno, "%s: calloc", __FUNCTION__);
+		goto done;
+	    }
+	    for (i=0; i<yt->yt_len; i++)
+		yt->yt_defidx[i] = -1;
+	    for (i=0; i<ys->ys_len; i++){
+		yc = ys->ys_stmt[i];
+		if (yc->ys_keyword != Y_LEAF || yc->ys_cv == NULL || 
+		    cv_flag(yc->ys_cv, V_UNSET))
+		    continue;
+		if ((yt->yt_defbody[yt->yt_deflen] = cv2str_dup(yc->ys_cv)) == NULL){
+		    clicon_err(OE_UNIX, errno, "cv2str_dup");
+		    goto done;
+		}
+		yt->yt_defleaf[yt->yt_deflen] = yc;
+		yt->yt_defidx[yc->ys_order] = yt->yt_deflen++;
+	    }
+	}
+    }
+    ys->ys_datatab = yt;
+    yt = NULL;
+    retval = 0;
+ done:
+    if (yt)
+	yang_datatab_free(yt);
+    return retval;
+}
+
+/*! Get data node tables of a yang statement, build them if not done
+ * @param[in]  ys    Yang statement
+ * @retval     yt    Data node tables
+ * @retval     NULL  Error
+ * @see xml_default, xml_order
+ */
+yang_datatab *
+yang_datatab_get(yang_stmt *ys)
+{
+    if (ys->ys_datatab == NULL && yang_datatab_build(ys) < 0)
+	return NULL;
+    return ys->ys_datatab;
+}
+
+/*! Position of a data node among the data nodes of a yang statement
+ * Data nodes under choice/case are counted as children of ys.
+ * @param[in]  ys   Yang statement, whose tables are built
+ * @param[in]  yc   Yang data node
+ * @retval     pos  Position of yc in yang order
+ * @retval    -1    yc is not a data node child of ys, or tables not built
+ * @see yang_datatab_get
+ */
+int
+yang_order(yang_stmt *ys, 
+	   yang_stmt *yc)
+{
+    yang_node *yp;
+
+    if (ys->ys_datatab == NULL || !yang_datanode(yc))
+	return -1;
+    yp = yc->ys_parent;
+    while (yp && (yp->yn_keyword == Y_CASE || yp->yn_keyword == Y_CHOICE))
+	yp = yp->yn_parent;
+    if (yp != (yang_node*)ys)
+	return -1;
+    return yc->ys_order;
+}
+
+/*! Build name index of a yang statement, yang_apply callback */
+static int
+ys_index_build(yang_stmt *ys, 
+	       void      *arg)
+{
+    return yang_index_build((yang_node*)ys);
+}
+
 /*! Free a single yang statement */
 static int 
 ys_free1(yang_stmt *ys)
 {
-    if (ys->ys_argument)
+    if (ys->ys_argument && (ys->ys_flags & YANG_FLAG_INTERN) == 0)
 	free(ys->ys_argument);
     if (ys->ys_cv)
 	cv_free(ys->ys_cv);
@@ -198,6 +584,10 @@ ys_free1(yang_stmt *ys)
 	cvec_free(ys->ys_cvec);
     if (ys->ys_typecache)
 	yang_type_cache_free(ys->ys_typecache);
+    if (ys->ys_index)
+	yang_index_free(ys->ys_index);
+    if (ys->ys_datatab)
+	yang_datatab_free(ys->ys_datatab);
     free(ys);
     return 0;
 }
@@ -232,6 +622,8 @@ yspec_free(yang_spec *yspec)
     }
     if (yspec->yp_stmt)
 	free(yspec->yp_stmt);
+    if (yspec->yp_index)
+	yang_index_free(yspec->yp_index);
     free(yspec);
     return 0;
 }
@@ -263,12 +655,14 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
+    ynew->ys_index = NULL;
+    ynew->ys_datatab = NULL;
     if (yold->ys_stmt)
 	if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
 	    clicon_err(OE_YANG, errno, "%s: calloc", __FUNCTION__);
 	    goto done;
 	}
-    if (yold->ys_argument)
+    if (yold->ys_argument && (yold->ys_flags & YANG_FLAG_INTERN) == 0)
 	if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
 	    clicon_err(OE_YANG, errno, "%s: strdup", __FUNCTION__);
 	    goto done;
@@ -337,6 +731,7 @@ yn_insert(yang_node *yn_parent,
 
     if (yn_realloc(yn_parent) < 0)
 	return -1;
+    yang_index_drop(yn_parent);
     yn_parent->yn_stmt[pos] = ys_child;
     ys_child->ys_parent = yn_parent;
     return 0;
@@ -387,6 +782,9 @@ yang_find(yang_node *yn,
     int i;
     int match = 0;
 
+    if (yn->yn_index && keyword != 0 && argument != NULL)
+	return yang_index_lookup(yn->yn_index->yx_stmt, yn->yn_index->yx_size,
+				 keyword, argument);
     for (i=0; i<yn->yn_len; i++){
 	ys = yn->yn_stmt[i];
 	if (keyword == 0 || ys->ys_keyword == keyword){
@@ -419,6 +817,10 @@ yang_find_datanode(yang_node *yn,
     yang_stmt *ysmatch = NULL;
     int        i, j;
 
+    /* Index of yang spec has top nodes, not its own children (modules) */
+    if (yn->yn_index && argument != NULL && yn->yn_keyword != Y_SPEC)
+	return yang_index_lookup(yn->yn_index->yx_data, yn->yn_index->yx_size,
+				 0, argument);
     for (i=0; i<yn->yn_len; i++){
 	ys = yn->yn_stmt[i];
 	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
@@ -466,6 +868,9 @@ yang_find_schemanode(yang_node *yn,
     yang_stmt *ysmatch = NULL;
     int        i, j;
 
+    if (yn->yn_index && argument != NULL && yn->yn_keyword != Y_SPEC)
+	return yang_index_lookup(yn->yn_index->yx_schema, yn->yn_index->yx_size,
+				 0, argument);
     for (i=0; i<yn->yn_len; i++){
 	ys = yn->yn_stmt[i];
 	if (ys->ys_keyword == Y_CHOICE){ /* Look for its children */
@@ -520,6 +925,9 @@ yang_find_topnode(yang_spec *ysp,
     yang_stmt *yc = NULL;
     int i;
 
+    if (ysp->yp_index && name != NULL)
+	return yang_index_lookup(schemanode?ysp->yp_index->yx_schema:ysp->yp_index->yx_data,
+				 ysp->yp_index->yx_size, 0, name);
     for (i=0; i<ysp->yp_len; i++){
 	ys = ysp->yp_stmt[i];
 	if (schemanode){
@@ -566,7 +974,7 @@ ys_flag_reset(yang_stmt *ys,
 {
     int flags = (intptr_t)arg;
 
-    ys->ys_flags |= ~flags;
+    ys->ys_flags &= ~flags;
     return 0;
 }
 
@@ -1043,6 +1451,27 @@ ys_populate_identity(yang_stmt *ys,
 }
 
 
+/*! Populate key statement with the key names of its list
+ * The names are parsed once here instead of at every lookup, see yang_key_cvec
+ */
+static int
+ys_populate_key(yang_stmt *ys, 
+		void      *arg)
+{
+    int   retval = -1;
+    cvec *cvk;
+
+    /* The value is a list of keys: <key>[ <key>]*  */
+    if ((cvk = yang_arg2cvec(ys, " ")) == NULL)
+	goto done;
+    if (ys->ys_cvec)
+	cvec_free(ys->ys_cvec);
+    ys->ys_cvec = cvk;
+    retval = 0;
+  done:
+    return retval;
+}
+
 /*! Populate with cligen-variables, default values, etc. Sanity checks on complete tree.
  *
  * We do this in 2nd pass after complete parsing to be sure to have a complete parse-tree
@@ -1079,6 +1508,10 @@ ys_populate(yang_stmt *ys,
 	if (ys_populate_identity(ys, arg) < 0)
 	    goto done;
 	break;
+    case Y_KEY:
+	if (ys_populate_key(ys, arg) < 0)
+	    goto done;
+	break;
     default:
 	break;
     }
@@ -1250,6 +1683,7 @@ yang_expand(yang_node *yn)
 	    /* Replace ys with ygrouping,... 
 	     * First enlarge parent vector 
 	     */
+	    yang_index_drop(yn);
 	    glen = ygrouping->ys_len;
 	    /* 
 	     * yn is parent: the children of ygrouping replaces ys.
@@ -1600,6 +2034,115 @@ ys_schemanode_check(yang_stmt *ys,
     return retval;
 }
 
+/*! Collect the target name of a leafref type statement
+ * The target name is the last step of the leafref path, eg "name" in
+ * "../../if:interface/if:name". If the path cannot be parsed, or has 
+ * predicates, eg "../../if:interface[if:name=current()/../ifname]/if:type",
+ * the yang spec is marked meaning that any node may be a target. A change
+ * of a predicate operand, here ifname or name, changes the leafref target
+ * without changing the node of the last step.
+ * @param[in]  ys   Yang type statement
+ * @param[in]  arg  cvec of target names
+ * @see yang_leafref_mark
+ */
+static int
+ys_leafref_name(yang_stmt *ys, 
+		void      *arg)
+{
+    int        retval = -1;
+    cvec      *cvv = (cvec*)arg;
+    yang_stmt *ypath;
+    cg_var    *cv;
+    char      *name = NULL;
+    char      *p;
+    int        level = 0;
+    int        pred = 0;
+
+    if (strcmp(ys->ys_argument, "leafref") != 0)
+	return 0;
+    if ((ypath = yang_find((yang_node*)ys, Y_PATH, NULL)) != NULL){
+	/* Find last step outside of predicates */
+	p = ypath->ys_argument;
+	name = p;
+	for (; *p; p++)
+	    if (*p == '['){
+		level++;
+		pred++;
+	    }
+	    else if (*p == ']')
+		level--;
+	    else if (*p == '/' && level == 0)
+		name = p+1;
+	if ((name = strdup(name)) == NULL){
+	    clicon_err(OE_YANG, errno, "strdup");
+	    goto done;
+	}
+	if ((p = strchr(name, '[')) != NULL)
+	    *p = '\0';
+	if ((p = strchr(name, ':')) != NULL)
+	    memmove(name, p+1, strlen(p+1)+1);
+    }
+    if (name == NULL || pred || strlen(name) == 0 || strcmp(name, "..") == 0)
+	ys_spec(ys)->yp_flags |= YANG_FLAG_LEAFREF;
+    else if (cvec_find(cvv, name) == NULL){
+	if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+	    clicon_err(OE_YANG, errno, "cvec_add");
+	    goto done;
+	}
+	if (cv_name_set(cv, name) == NULL){
+	    clicon_err(OE_YANG, errno, "cv_name_set");
+	    goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    return retval;
+}
+
+/*! Mark data node with YANG_FLAG_LEAFREF if its name is a leafref target name
+ * @param[in]  ys   Yang statement
+ * @param[in]  arg  cvec of target names
+ */
+static int
+ys_leafref_target_mark(yang_stmt *ys, 
+		       void      *arg)
+{
+    cvec *cvv = (cvec*)arg;
+
+    if (yang_datanode(ys) && cvec_find(cvv, ys->ys_argument) != NULL)
+	ys->ys_flags |= YANG_FLAG_LEAFREF;
+    return 0;
+}
+
+/*! Mark all data nodes that may be the target of a leafref path
+ * Targets are found by name only, which may mark more nodes than necessary,
+ * but never too few.
+ * @param[in]  ysp  Yang spec
+ * @see yang_leafref_target
+ */
+static int
+yang_leafref_mark(yang_spec *ysp)
+{
+    int   retval = -1;
+    cvec *cvv;
+
+    if ((cvv = cvec_new(0)) == NULL){
+	clicon_err(OE_YANG, errno, "cvec_new");
+	goto done;
+    }
+    if (yang_apply((yang_node*)ysp, Y_TYPE, ys_leafref_name, cvv) < 0)
+	goto done;
+    if (yang_apply((yang_node*)ysp, -1, ys_leafref_target_mark, cvv) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    return retval;
+}
+
 /*! Parse top yang module including all its sub-modules. Expand and populate yang tree
  *
  * @param[in] h        CLICON handle
@@ -1662,6 +2205,16 @@ yang_parse(clicon_handle h,
     if (yang_apply((yang_node*)ysp, -1, ys_schemanode_check, NULL) < 0)
 	goto done;
 
+    /* Step 5: Build name indexes for yang_find* lookups of the expanded tree */
+    if (yang_apply((yang_node*)ysp, -1, ys_index_build, NULL) < 0)
+	goto done;
+    if (yang_index_build((yang_node*)ysp) < 0)
+	goto done;
+
+    /* Step 6: Mark nodes that leafrefs may refer to, see yang_leafref_target */
+    if (yang_leafref_mark(ysp) < 0)
+	goto done;
+
     retval = 0;
   done:
     return retval;
@@ -2004,6 +2557,22 @@ yang_mandatory(yang_stmt *ys)
     return 0;
 }
 
+/*! Return if this node may be the target of a leafref path
+ * Used to decide if leafrefs need to be validated when the node is removed
+ * or changed.
+ * @retval 1 Some leafref in the yang spec may refer to this node
+ * @retval 0 No leafref refers to this node
+ */
+int
+yang_leafref_target(yang_stmt *ys)
+{
+    yang_spec *ysp;
+
+    if ((ysp = ys_spec(ys)) != NULL && (ysp->yp_flags & YANG_FLAG_LEAFREF))
+	return 1;
+    return (ys->ys_flags & YANG_FLAG_LEAFREF) != 0;
+}
+
 /*! Return config state of this node
  * config statement is default true. 
  * Note that a node with config=false may not have a sub
@@ -2110,6 +2679,37 @@ yang_arg2cvec(yang_stmt *ys,
     return cvv;
 }
 
+/*! Get the key names of a yang list
+ *
+ * The names are parsed from the key statement when the yang spec is populated
+ * and kept there, so this is cheap compared to yang_arg2cvec().
+ * @param[in]  ys   Yang list statement
+ * @retval     cvk  Vector of key names as strings. Do not free.
+ * @retval     NULL No key statement found, clicon_err called
+ * @code
+ *    cvec   *cvk;
+ *    cg_var *cvi = NULL;
+ *    if ((cvk = yang_key_cvec(ylist)) == NULL)
+ *       goto err;
+ *    while ((cvi = cvec_each(cvk, cvi)) != NULL) 
+ *         ...cv_string_get(cvi);
+ * @endcode
+ * @see yang_arg2cvec
+ */
+cvec *
+yang_key_cvec(yang_stmt *ys)
+{
+    yang_stmt *ykey;
+
+    if ((ykey = yang_find((yang_node*)ys, Y_KEY, NULL)) == NULL ||
+	ykey->ys_cvec == NULL){
+	clicon_err(OE_YANG, 0, "%s: List statement \"%s\" has no key", 
+		   __FUNCTION__, ys->ys_argument);
+	return NULL;
+    }
+    return ykey->ys_cvec;
+}
+
 /*! Check if yang node yn has key-stmt as child which matches name
  *
  * @param[in]  yn   Yang node with sub-statements (look for a key child)
@@ -167,6 +167,7 @@
 #include "clixon_handle.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
+#include "clixon_string.h"
 #include "clixon_yang.h"
 #include "clixon_yang_parse.h"
 
@@ -257,6 +258,15 @@ ysp_add(struct clicon_yang_yacc_arg *yy,
 	goto err;
     /* NOTE: does not make a copy of string, ie argument is 'consumed' here */
     ys->ys_argument = argument;
+    /* Share names of schema nodes with xml node names */
+    if (argument && yang_schemanode(ys)){
+	if ((ys->ys_argument = clicon_intern(argument)) == NULL){
+	    ys->ys_argument = argument;
+	    goto err;
+	}
+	free(argument);
+	ys->ys_flags |= YANG_FLAG_INTERN;
+    }
     if (yn_insert(yn, ys) < 0) /* Insert into hierarchy */
 	goto err; 
     if (ys_parse_sub(ys) < 0)     /* Check statement-specific syntax */
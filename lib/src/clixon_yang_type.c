@@ -107,6 +107,66 @@ yang_builtin(char *type)
     return 0;
 }
 
+/*! Compile a yang pattern to a posix regexp
+ * The pattern is anchored in the same way as in cligen match_regexp.
+ * @param[in]  pattern  Yang pattern
+ * @param[out] regex    Compiled regex_t, free with regfree and free. Set to NULL
+ *                      if pattern does not compile, then match_regexp fails
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+yang_pattern_compile(char  *pattern,
+		     void **regex)
+{
+    int      retval = -1;
+    regex_t *re = NULL;
+    char    *anchored = NULL;
+    size_t   len;
+
+    *regex = NULL;
+    len = strlen(pattern) + 5;
+    if ((anchored = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    snprintf(anchored, len, "^(%s)$", pattern);
+    if ((re = malloc(sizeof(*re))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (regcomp(re, anchored, REG_NOSUB|REG_EXTENDED) != 0){
+	clicon_debug(1, "%s: regcomp: %s", __FUNCTION__, pattern);
+	free(re);
+	re = NULL;
+    }
+    *regex = re;
+    retval = 0;
+ done:
+    if (anchored)
+	free(anchored);
+    return retval;
+}
+
+/*! Match a string with a yang pattern, using a compiled pattern if cached
+ * @param[in]  str      String
+ * @param[in]  pattern  Yang pattern, as resolved with yang_type_resolve
+ * @param[in]  ycache   Type cache of the type statement, or NULL
+ * @retval    -1        Error
+ * @retval     0        No match
+ * @retval     1        Match
+ */
+static int
+yang_pattern_match(char            *str,
+		   char            *pattern,
+		   yang_type_cache *ycache)
+{
+    if (ycache && ycache->yc_regex && ycache->yc_pattern &&
+	(ycache->yc_pattern == pattern || strcmp(ycache->yc_pattern, pattern) == 0))
+	return regexec(ycache->yc_regex, str, 0, NULL, 0) == 0;
+    return match_regexp(str, pattern);
+}
+
 /*! Set type cache for yang type
  */
 int
@@ -142,6 +202,8 @@ yang_type_cache_set(yang_type_cache **ycache0,
 	clicon_err(OE_UNIX, errno, "strdup");
 	goto done;
     }
+    if (pattern && yang_pattern_compile(pattern, &ycache->yc_regex) < 0)
+	goto done;
     ycache->yc_fraction  = fraction;
     retval = 0;
  done:
@@ -202,6 +264,10 @@ yang_type_cache_free(yang_type_cache *ycache)
 	cv_free(ycache->yc_maxcv);
     if (ycache->yc_pattern)
 	free(ycache->yc_pattern);
+    if (ycache->yc_regex){
+	regfree(ycache->yc_regex);
+	free(ycache->yc_regex);
+    }
     free(ycache);
     return 0;
 }
@@ -210,7 +276,8 @@ yang_type_cache_free(yang_type_cache *ycache)
  * @param[in]  ys  This is a type statement
  * @param[in]  arg Not used
  * Typically only called once when loading te yang type system.
- * @note unions not cached
+ * A union is cached as the resolved union type only, its member types are 
+ * cached in their own type statements.
  */
 int
 ys_resolve_type(yang_stmt *ys, 
@@ -229,15 +296,9 @@ ys_resolve_type(yang_stmt *ys,
 			  &options, &mincv, &maxcv, &pattern, &fraction) < 0)
 	goto done;
 
-    if (resolved && strcmp(resolved->ys_argument, "union")==0)
-	; 
-    /* skip unions since they may have different sets of options, mincv, etc 
-     * You would have to resolve all sub-types also recursively
-     */
-    else
-	if (yang_type_cache_set(&ys->ys_typecache, 
-				resolved, options, mincv, maxcv, pattern, fraction) < 0)
-	    goto done;
+    if (yang_type_cache_set(&ys->ys_typecache, 
+			    resolved, options, mincv, maxcv, pattern, fraction) < 0)
+	goto done;
     retval = 0;
  done:
     return retval;
@@ -391,6 +452,7 @@ cv_validate1(cg_var      *cv,
 	     cg_var      *range_min,
 	     cg_var      *range_max, 
 	     char        *pattern,
+	     yang_type_cache *ycache,
 	     yang_stmt   *yrestype,
 	     char        *restype,
 	     char       **reason)
@@ -537,7 +599,7 @@ cv_validate1(cg_var      *cv,
 	    }
 	}
 	if ((options & YANG_OPTIONS_PATTERN) != 0){
-	    if ((retval2 = match_regexp(str, pattern)) < 0){
+	    if ((retval2 = yang_pattern_match(str, pattern, ycache)) < 0){
 		clicon_err(OE_DB, 0, "match_regexp: %s", pattern);
 		return -1;
 	    }
@@ -625,7 +687,8 @@ ys_cv_validate_union_one(yang_stmt *ys,
 	    goto done;
 	}
 	if ((retval = cv_validate1(cvt, cvtype, options, range_min, range_max, 
-				   pattern, yrt, restype, reason)) < 0)
+				   pattern, yt->ys_typecache, yrt, restype, 
+				   reason)) < 0)
 	    goto done;
     }
  done:
@@ -686,6 +749,7 @@ ys_cv_validate(cg_var    *cv,
     enum cv_type    cvtype;
     char           *type;  /* orig type */
     yang_stmt      *yrestype; /* resolved type */
+    yang_stmt      *ytype;
     char           *restype;
     uint8_t         fraction = 0; 
     int             retval2;
@@ -706,6 +770,7 @@ ys_cv_validate(cg_var    *cv,
     restype = yrestype?yrestype->ys_argument:NULL;
     if (clicon_type2cv(type, restype, &cvtype) < 0)
 	goto done;
+    ytype = yang_find((yang_node*)ys, Y_TYPE, NULL); /* For compiled pattern */
 
     if (cv_type_get(ycv) != cvtype){
 	/* special case: dbkey has rest syntax-> cv but yang cant have that */
@@ -727,7 +792,8 @@ ys_cv_validate(cg_var    *cv,
     }
     else
 	if ((retval = cv_validate1(cv, cvtype, options, range_min, range_max, pattern,
-				yrestype, restype, reason)) < 0)
+				   ytype?ytype->ys_typecache:NULL,
+				   yrestype, restype, reason)) < 0)
 	    goto done;
   done:
     if (cvt)
@@ -89,6 +89,17 @@ run(){
     new "datastore $name get"
     expectfn "$datastore $conf get /" "^$db$"
 
+    new "datastore $name cached get"
+    expectfn "$datastore $conf -c get /" "^$db$"
+
+    new "datastore $name cached get leaf"
+    expectfn "$datastore $conf -c get /x/g" "^<config><x><g>astring</g></x></config>$"
+
+    # Same handle, file changed in place with same size within a second
+    echo -n "<config><x><g>astring</g></x></config>" > $dir/candidate_db
+    new "datastore $name cached get after file changed"
+    expectfn "$datastore $conf -c reget /x/g $dir/candidate_db <config><x><g>bstring</g></x></config>" "^<config><x><g>astring</g></x></config> <config><x><g>bstring</g></x></config>$"
+
     new "datastore $name put top create"
     expectfn "$datastore $conf put create <config><x/></config>" "" # error
 
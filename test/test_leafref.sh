@@ -94,6 +94,81 @@ expectfn "$clixon_cli -1f $clixon_cf -y /tmp/leafref.yang -l o set default-addre
 new "cli leafref validate"
 expectfn "$clixon_cli -1f $clixon_cf -y /tmp/leafref.yang -l o validate" "^$"
 
+new "leafref discard-changes"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref add address"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref.yang" "<rpc><edit-config><target><candidate/></target><config><default-address><relname>eth0</relname><address>192.0.2.1</address></default-address></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref commit address"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref.yang" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref change predicate operand"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref.yang" "<rpc><edit-config><target><candidate/></target><config><default-address><relname>lo</relname></default-address></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref commit changed predicate operand (should fail)"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref.yang" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-tag>invalid-value</error-tag>"
+
+new "leafref discard-changes"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Leafrefs without predicates: only removed or changed targets are checked
+cat <<EOF > /tmp/leafref2.yang
+module example{
+    import ietf-ip {
+      prefix ip;
+    }
+    container default-address {
+         leaf absname {
+             type leafref {
+                 path "/ip:interfaces/ip:interface/ip:name";
+             }
+         }
+         leaf descr {
+             type leafref {
+                 path "../../interfaces/interface/description";
+             }
+         }
+    }
+}
+EOF
+
+new "leafref2 kill backend"
+sudo clixon_backend -zf $clixon_cf
+if [ $? -ne 0 ]; then
+    err
+fi
+
+new "leafref2 start backend"
+sudo clixon_backend -If $clixon_cf -y /tmp/leafref2.yang
+if [ $? -ne 0 ]; then
+    err
+fi
+
+new "leafref2 base config"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><edit-config><target><candidate/></target><config><interfaces><interface><name>eth0</name><type>eth</type><description>mydesc</description></interface><interface><name>lo</name><type>lo</type></interface></interfaces><default-address><absname>eth0</absname><descr>mydesc</descr></default-address></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref2 base commit"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref2 delete target"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><edit-config><target><candidate/></target><config><interfaces><interface operation=\"delete\"><name>eth0</name></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref2 commit deleted target (should fail)"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-tag>invalid-value</error-tag>"
+
+new "leafref2 discard-changes"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref2 change target"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><edit-config><target><candidate/></target><config><interfaces><interface><name>eth0</name><description>otherdesc</description></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "leafref2 commit changed target (should fail)"
+expecteof "$clixon_netconf -qf $clixon_cf -y /tmp/leafref2.yang" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-tag>invalid-value</error-tag>"
+
+new "leafref2 discard-changes"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
 new "Kill backend"
 # Check if still alive
 pid=`pgrep clixon_backend`
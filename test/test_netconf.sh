@@ -59,6 +59,12 @@ expecteof "$clixon_netconf -qf $clixon_cf" '<rpc><get-config><source><candidate/
 new "netconf get config xpath parent"
 expecteof "$clixon_netconf -qf $clixon_cf" '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/interfaces/interface[name=eth1]/enabled/../.."/></get-config></rpc>]]>]]>' "^<rpc-reply><data><interfaces><interface><name>eth/0/0</name><enabled>true</enabled></interface><interface><name>eth1</name><enabled>true</enabled><ipv4><enabled>true</enabled><forwarding>false</forwarding><address><ip>9.2.3.4</ip><prefix-length>24</prefix-length></address></ipv4></interface></interfaces></data></rpc-reply>]]>]]>$"
 
+new "netconf get config xpath parent of several children"
+expecteof "$clixon_netconf -qf $clixon_cf" '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/interfaces/interface/*/.."/></get-config></rpc>]]>]]>' "^<rpc-reply><data><interfaces><interface><name>eth/0/0</name><enabled>true</enabled></interface><interface><name>eth1</name><enabled>true</enabled><ipv4><enabled>true</enabled><forwarding>false</forwarding><address><ip>9.2.3.4</ip><prefix-length>24</prefix-length></address></ipv4></interface></interfaces></data></rpc-reply>]]>]]>$"
+
+new "netconf get config xpath descendants duplicate parents"
+expecteof "$clixon_netconf -qf $clixon_cf" '<rpc><get-config><source><candidate/></source><filter type="xpath" select="//enabled/../.."/></get-config></rpc>]]>]]>' "^<rpc-reply><data><interfaces><interface><name>eth/0/0</name><enabled>true</enabled></interface><interface><name>eth1</name><enabled>true</enabled><ipv4><enabled>true</enabled><forwarding>false</forwarding><address><ip>9.2.3.4</ip><prefix-length>24</prefix-length></address></ipv4></interface></interfaces></data></rpc-reply>]]>]]>$"
+
 new "netconf validate missing type"
 expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply><rpc-error>"
 
@@ -134,6 +140,84 @@ expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><fib-route><routing-instance-na
 new "netconf subscription"
 expectwait "$clixon_netconf -qf $clixon_cf" "<rpc><create-subscription><stream>ROUTING</stream></create-subscription></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]><notification><event>Routing notification</event></notification>]]>]]>$" 30
 
+# Config larger than 64K does not fit in version 1 message header
+cfg=""
+for (( i=0; i<2000; i++ )); do
+    cfg="$cfg<interface><name>eth$i</name><type>eth</type></interface>"
+done
+
+new "netconf edit large config"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><edit-config><target><candidate/></target><config><interfaces>$cfg</interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get large config"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "<interface><name>eth1999</name><type>eth</type><enabled>true</enabled></interface>"
+
+# Client of an earlier release: message header is only a 16-bit length
+cat <<EOF > /tmp/msgv1.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+int
+main(int argc, char **argv)
+{
+    int                s;
+    struct sockaddr_un addr;
+    char               req[1024];
+    uint16_t           len;
+    char              *body;
+    ssize_t            n;
+    size_t             pos = 0;
+
+    if (fgets(req, sizeof(req), stdin) == NULL)
+	return 1;
+    req[strcspn(req, "\n")] = '\0';
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	return 1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, argv[1], sizeof(addr.sun_path)-1);
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+	return 1;
+    len = htons(sizeof(len) + strlen(req) + 1);
+    if (write(s, &len, sizeof(len)) != sizeof(len) ||
+	write(s, req, strlen(req)+1) != strlen(req)+1)
+	return 1;
+    if (read(s, &len, sizeof(len)) != sizeof(len) || ntohs(len) <= sizeof(len))
+	return 1;
+    len = ntohs(len) - sizeof(len);
+    if ((body = calloc(len+1, 1)) == NULL)
+	return 1;
+    while (pos < len && (n = read(s, body+pos, len-pos)) > 0)
+	pos += n;
+    if (pos != len)
+	return 1;
+    printf("%s\n", body);
+    return 0;
+}
+EOF
+
+new "compile version 1 client"
+cc -o /tmp/msgv1 /tmp/msgv1.c
+if [ $? -ne 0 ]; then
+    err "compile /tmp/msgv1.c"
+fi
+sock=`awk '$1=="CLICON_SOCK" {print $2}' $clixon_cf`
+
+new "version 1 client get-config"
+expecteof "/tmp/msgv1 $sock" "<rpc><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/interfaces/interface[name=eth7]\"/></get-config></rpc>" "^<rpc-reply><data><interfaces><interface><name>eth7</name><type>eth</type><enabled>true</enabled></interface></interfaces></data></rpc-reply>$"
+
+new "version 1 client get-config too big for version 1 header"
+expecteof "/tmp/msgv1 $sock" "<rpc><get-config><source><candidate/></source></get-config></rpc>" "<error-tag>too-big</error-tag>"
+
+new "netconf discard-changes"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><discard-changes/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
 new "Kill backend"
 # Check if still alive
 pid=`pgrep clixon_backend`
@@ -0,0 +1,70 @@
+#!/bin/bash
+# Performance tests of large lists using the routing example.
+# Prints elapsed time of each operation. The number of list entries can be
+# set with the perfnr environment variable, eg: perfnr=100000 ./test_perf.sh
+# Compare times with a previous build of clixon by running the same script.
+
+# include err() and new() functions
+. ./lib.sh
+
+clixon_netconf=clixon_netconf
+perfnr=${perfnr:-10000}
+TIMEFORMAT="    %Rs"
+
+# kill old backend (if any)
+new "kill old backend"
+sudo clixon_backend -zf $clixon_cf
+if [ $? -ne 0 ]; then
+    err
+fi
+new "start backend"
+sudo clixon_backend -If $clixon_cf
+if [ $? -ne 0 ]; then
+    err
+fi
+
+cfg=""
+for (( i=0; i<$perfnr; i++ )); do
+    cfg="$cfg<interface><name>eth$i</name><type>eth</type></interface>"
+done
+
+new "perf edit-config $perfnr entries"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><edit-config><target><candidate/></target><config><interfaces>$cfg</interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Commit computes the diff between running and candidate
+new "perf commit $perfnr added entries"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Get reads the datastore, binds yang, adds defaults and orders children
+new "perf get-config $perfnr entries"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><get-config><source><running/></source></get-config></rpc>]]>]]>" "<interface><name>eth0</name>"
+
+new "perf get-config one entry of $perfnr"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><get-config><source><running/></source><filter type=\"xpath\" select=\"/interfaces/interface[name=eth$((perfnr/2))]\"/></get-config></rpc>]]>]]>" "<name>eth$((perfnr/2))</name>"
+
+new "perf change one entry"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><edit-config><target><candidate/></target><config><interfaces><interface><name>eth$((perfnr/2))</name><enabled>false</enabled></interface></interfaces></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "perf commit one changed entry of $perfnr"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "perf check changed entry"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><get-config><source><running/></source><filter type=\"xpath\" select=\"/interfaces/interface[name=eth$((perfnr/2))]/enabled\"/></get-config></rpc>]]>]]>" "<enabled>false</enabled>"
+
+new "perf delete all"
+expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><edit-config><target><candidate/></target><config><interfaces operation=\"delete\"/></config><default-operation>none</default-operation></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "perf commit $perfnr deleted entries"
+time expecteof "$clixon_netconf -qf $clixon_cf" "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Kill backend"
+# Check if still alive
+pid=`pgrep clixon_backend`
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+sudo clixon_backend -zf $clixon_cf
+if [ $? -ne 0 ]; then
+    err "kill backend"
+fi
@@ -0,0 +1,93 @@
+#!/bin/bash
+# XML library micro-benchmark: build lists of 10k-1M entries.
+# Compiles a small program against the installed clixon library and prints
+# elapsed times. Appending to vectors of exact size (realloc with one more
+# element, as before) is shown for comparison with cxvec_append.
+# Set sizes with the perfsizes environment variable, eg:
+#   perfsizes="10000 100000" ./test_perf_xml.sh
+
+# include err() and new() functions
+. ./lib.sh
+
+perfsizes=${perfsizes:-"10000 100000 1000000"}
+
+cat <<EOF > /tmp/perf_xml.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <cligen/cligen.h>
+#include <clixon/clixon.h>
+
+static double
+elapsed(struct timeval *t0)
+{
+    struct timeval t1, t;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &t);
+    return t.tv_sec + t.tv_usec/1000000.0;
+}
+
+int
+main(int argc, char **argv)
+{
+    int            n = atoi(argv[1]);
+    int            i;
+    struct timeval t0;
+    cxobj         *xt;
+    cxobj         *x;
+    cxobj        **vec = NULL;
+    size_t         veclen = 0;
+    char           name[32];
+
+    gettimeofday(&t0, NULL);
+    if ((xt = xml_new_arena("top")) == NULL)
+	return 1;
+    for (i=0; i<n; i++){
+	snprintf(name, sizeof(name), "%d", i);
+	if ((x = xml_new("entry", xt)) == NULL)
+	    return 1;
+	if ((x = xml_new("body", x)) == NULL)
+	    return 1;
+	xml_type_set(x, CX_BODY);
+	if (xml_value_set(x, name) < 0)
+	    return 1;
+    }
+    xml_arena_close(xt);
+    printf("%8d build list:            %.3fs\n", n, elapsed(&t0));
+    gettimeofday(&t0, NULL);
+    for (i=0; i<n; i++)
+	if (cxvec_append(xml_child_i(xt, i), &vec, &veclen) < 0)
+	    return 1;
+    printf("%8d cxvec_append:          %.3fs\n", n, elapsed(&t0));
+    free(vec);
+    vec = NULL;
+    gettimeofday(&t0, NULL);
+    for (i=0; i<n; i++){
+	if ((vec = realloc(vec, (i+1)*sizeof(cxobj*))) == NULL)
+	    return 1;
+	vec[i] = xml_child_i(xt, i);
+    }
+    printf("%8d exact realloc (old):   %.3fs\n", n, elapsed(&t0));
+    free(vec);
+    gettimeofday(&t0, NULL);
+    xml_free(xt);
+    printf("%8d free list:             %.3fs\n", n, elapsed(&t0));
+    return 0;
+}
+EOF
+
+new "compile xml micro-benchmark"
+cc -O2 -o /tmp/perf_xml /tmp/perf_xml.c -lclixon -lcligen
+if [ $? -ne 0 ]; then
+    err "compile /tmp/perf_xml.c"
+fi
+
+for n in $perfsizes; do
+    new "xml micro-benchmark $n entries"
+    /tmp/perf_xml $n
+    if [ $? -ne 0 ]; then
+	err "perf_xml $n"
+    fi
+done